@@ -10,8 +10,77 @@ This project simulates a process manager of an operating system.
 #include <phase1.h>
 #include <string.h>  
 #include <stdlib.h> 
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <usloss.h>
 
+/*
+The process table grows by this many slots at a time
+*/
+#define CHUNK_SIZE 64
+
+/*
+Number of run queue levels. Each level has one bit in readyBitmap, so this
+must not exceed 64. Priorities are spread over the levels so that there is
+room between two priorities for finer grained scheduling.
+*/
+#define NUM_LEVELS          64
+#define LEVELS_PER_PRIORITY 8
+
+/*
+Lowest priority spork() accepts, init runs below it
+*/
+#define LOWEST_PRIORITY 5
+
+/*
+Length of a time slice in microseconds (the unit of currentTime())
+*/
+#define TIME_SLICE 80000
+
+/*
+In SCHED_MLFQ mode a process that uses up a whole time slice drops
+MLFQ_STEP levels, but never below MLFQ_BOTTOM_LEVEL, the last level before
+init's. A process that blocks climbs back MLFQ_STEP levels, but never above
+the level of its priority. Every MLFQ_BOOST_PERIOD microseconds every
+process is put back at the level of its priority.
+*/
+#define MLFQ_STEP          LEVELS_PER_PRIORITY
+#define MLFQ_BOTTOM_LEVEL  (LOWEST_PRIORITY * LEVELS_PER_PRIORITY - 1)
+#define MLFQ_BOOST_PERIOD  1000000
+
+/*
+In SCHED_FAIR mode the processes of priority 1 to LOWEST_PRIORITY are kept in
+a min-heap by virtual runtime, the cpu time they used scaled by their weight.
+Priority 3 has weight 4 and its virtual runtime is real cpu time, each
+priority above doubles the weight. The running process is preempted once it
+is FAIR_GRANULARITY ahead of the process that is furthest behind, and a
+process that wakes up is given at most FAIR_WAKE_CREDIT of catching up.
+*/
+#define FAIR_GRANULARITY   20000
+#define FAIR_WAKE_CREDIT   TIME_SLICE
+
+/*
+Real-time processes are made by sporkRealtime() with a period and a budget of
+cpu time per period, both in microseconds. They run before everything else,
+earliest deadline first. Their budgets may add up to at most RT_UTILIZATION_LIMIT
+millionths of the cpu, so the other processes always get some of it.
+*/
+#define RT_UTILIZATION_LIMIT 900000
+
+/*
+Stacks are kept in a pool so they can be reused. Stack class i holds stacks of
+USLOSS_MIN_STACK << i bytes, larger stacks are not pooled. A class keeps at most
+STACK_POOL_MAX free stacks, and STACK_POOL_PREWARM of the smallest stacks are
+made by phase1_init().
+Stacks are mmap'd without reserving memory, so a page only costs memory once it
+is touched, and the page below each stack is a PROT_NONE guard page.
+*/
+#define STACK_CLASSES      8
+#define STACK_POOL_MAX     32
+#define STACK_POOL_PREWARM 4
+
 /*
 This struct is the process control block
 */
@@ -24,28 +93,120 @@ typedef enum {
     QUIT  
 } processState;
 
+/**
+The part of a process the scheduler never looks at: the saved context (a
+whole ucontext_t, about 1 KB) and the name. It is kept apart from the
+process so that walking the run queues and the pid map does not drag it
+through the cache. Each slot of the process table has its own for good.
+*/
+typedef struct processCold {
+    USLOSS_Context context;
+    char name[MAXNAME];
+} processCold;
+
 /**
 This struct will act as a Process Control Block
 */
 typedef struct process {
+    // what every dispatch reads comes first and fits in one 64 byte cache
+    // line, what only some policies read fills the next one
     int pid; 
     processState state;
-    USLOSS_Context context;
     int priority; 
-    char name[MAXNAME];  
-    struct process *next; // used for run queuse
+    int level;   // run queue index the process is queued at
+    struct process *next; // used for run queuse, and the free list while EMPTY
+    struct process *prev;
+    int timeUsed;     // cpu time used in the current time slice
+    int sliceStart;   // time the process was last charged
+    int readySince;   // time the process was last put in a ready queue
+    int period;       // real-time: length of a period, 0 for other processes
+    int budgetUsed;   // real-time: cpu time used in this period
+    int budget;       // real-time: cpu time allowed per period
+    int deadline;     // real-time: end of this period
+    int rtParked;     // real-time: blocked until the next period starts
+    int cpuTime;      // total cpu time used
+    int maxWait;      // longest time it waited in a ready queue
+    int ageBoost;     // levels the process moved up by aging while it waited
+    int inheritLevel; // best level lent by a process waiting for this one, NUM_LEVELS for none
+    int64_t vruntime; // SCHED_FAIR: weighted cpu time
+    int heapIndex;    // SCHED_FAIR: index in fairHeap, -1 if not in it
+    processCold *cold;
+
     struct process *parent;        
     struct process *first_child; 
     struct process *next_sibling;
+    struct process *prev_sibling;
+    struct process *zombieHead;  // terminated children that have not been joined, newest first
+    struct process *zombieTail;
+    struct process *nextZombie;
+    struct process *prevZombie;
+    struct process *joinTarget;  // the child joinPid() is waiting for, NULL for any child
+    struct process *zapTarget;   // the process zap() is waiting for
+    struct process *groupZapper; // the process zapGroup() or zapTree() blocked until this one quits
+    int zapPending;   // members zapGroup() or zapTree() is still waiting for
+    int gid;          // process group, 0 for none
+    int detached;     // nobody joins the process, quit() frees it
     int exit_status;                
     int (*startFunc)(void *);
     void *arg;                       
     void *stack; 
-    struct process *zapList;  
-    struct process *nextZap;  
-    int timeUsed;  
+    int stackSize;   // the size that was allocated, at least what spork() asked for
+    waitQueue zappers;        // processes blocked in zap() until this one quits
+    waitQueue childWait;      // where the process blocks in join() and joinPid()
+    waitQueue *waitingOn;     // the queue the process is blocked on, NULL for none
+    struct process *nextWaiter;
+    struct process *prevWaiter;
+    int blockReason;          // why the process is BLOCKED, one of BLOCKED_*
+    int rtDone;       // real-time: waitPeriod() was called in this period
+    int deadlineMisses;
+    struct process *nextRt;  // list of all real-time processes
 } process;
 
+/*
+This struct is the list of free stacks of one stack class.
+A free stack holds the pointer to the next one in its last bytes, the top
+of the stack, which is the page every process touches anyway.
+*/
+typedef struct StackPool {
+    void *head;
+    int count;
+} StackPool;
+
+/*
+This struct is a job of a worker pool. A slot is on the free list, the
+pending list or the done list of its pool.
+*/
+typedef struct Job {
+    int id;
+    int (*func)(void *);
+    void *arg;
+    int result;
+    struct Job *next;
+} Job;
+
+/*
+This struct is a worker pool: workers that poolCreate() sporks once and that
+run submitted jobs until poolDestroy(). A worker with nothing to do waits on
+idle, a process waiting for a result waits on collectors.
+*/
+typedef struct WorkerPool {
+    process *owner;       // the parent of the workers, NULL if the pool is unused
+    int size;
+    int *workerPids;
+    int stopping;         // poolDestroy() was called, the workers quit when they run out of jobs
+    int generation;       // goes up every time the pool is destroyed, so waiters can tell
+    int nextJobId;
+    int outstanding;      // jobs submitted and not collected yet
+    Job jobs[MAXJOBS];
+    Job *freeJobs;
+    Job *pendingHead;
+    Job *pendingTail;
+    Job *doneHead;
+    Job *doneTail;
+    waitQueue idle;
+    waitQueue collectors;
+} WorkerPool;
+
 /*
 This struct is a runqueue
 */  
@@ -54,6 +215,23 @@ typedef struct RunQueue {
     process *tail;  
 } RunQueue;
 
+/*
+This struct is a scheduling policy. dispatcher(), spork(), blockMe(),
+unblockProc() and the rest of the kernel only reach the ready processes
+through the ops of the policy in use. Real-time processes are scheduled
+earliest deadline first before the policy gets a say.
+*/
+typedef struct SchedOps {
+    const char *name;
+    void (*enqueue)(process *proc, int front);  // front: it was preempted with time left
+    void (*dequeue)(process *proc);
+    process *(*pickNext)(void);                 // best ready process, NULL if none
+    int (*keepsRunning)(process *proc);         // should the running process keep the cpu
+    void (*tick)(process *proc);                // every dispatch, proc is the running process
+    void (*block)(process *proc);               // proc is about to block
+    void (*wake)(process *proc);                // proc was blocked and is ready again
+} SchedOps;
+
 /*
 
 PROTOTYPES
@@ -67,14 +245,84 @@ int enableInterrupts(void);
 int disableInterrupts(void);
 
 // Process Control and Scheduling
+void idle_main(void);
+int growProcessTable(void);
+void initSlot(process *proc);
+process *allocProcess(void);
+void freeProcess(process *proc);
+process *findProcess(int pid);
+int findFreeSlot(int start);
+void markSlot(int slot, int free);
+int growPidMap(void);
 void removeChild(process *parent, process *child);
+void addZombie(process *parent, process *child);
+void removeZombie(process *parent, process *child);
+int reapChild(process *child, int *status);
 void enqueue(process *proc);
+void enqueueFront(process *proc);
 void removeFromRunQueue(process *proc);
+int isQueued(process *proc);
 process *select_next_process(void);
-void context_switch(process *next_proc);
+void context_switch(process *next_proc, int sliceUsed);
+void chargeTime(process *proc);
+
+
+// Stack Pool
+int stackClass(int size);
+void *allocStack(int size, int *allocSize);
+void freeStack(void *stack, int size);
+void *mapStack(int size);
+void unmapStack(void *stack, int size);
+int stackUsed(process *proc);
 
 // Run Queue Management
+int priorityToLevel(int priority);
+int homeLevel(process *proc);
+void inheritPriority(process *waiter, process *target);
+void recomputeInheritance(process *target);
+void ageReadyProcesses(int now);
+void noteAging(process *proc);
+void setLevel(process *proc, int level);
+void mlfqDemote(process *proc);
+void mlfqPromote(process *proc);
+void mlfqBoost(void);
+void mlfqTick(process *proc);
+int keepsRunning(process *proc);
+void wakeUp(process *proc);
+void unlinkWaiter(process *proc);
+int wakeWaiters(waitQueue *queue, int all);
+void blockOn(waitQueue *queue, int reason, int front);
+void schedNop(process *proc);
+void rqEnqueue(process *proc, int front);
+void rqDequeue(process *proc);
+process *rqPickNext(void);
+int rqKeepsRunning(process *proc);
+int inFairClass(process *proc);
+int fairWeight(int priority);
+void fairEnqueue(process *proc, int front);
+void fairDequeue(process *proc);
+process *fairPickNext(void);
+int fairKeepsRunning(process *proc);
+void fairWake(process *proc);
+void fairAdvanceClock(void);
+void fairHeapUp(int i);
+void fairHeapDown(int i);
+void fairHeapInsert(process *proc);
+void fairHeapRemove(process *proc);
+void edfInsert(process *proc);
+void edfRemove(process *proc);
+void rtRelease(int now);
+int rtWaiting(void);
+void rtForget(process *proc);
+int sporkProcess(char *name, int(*func)(void *), void *arg, int stacksize,
+                 int priority, int period, int budget, int detached);
+int poolWorker(void *arg);
+WorkerPool *findPool(int pool);
 void dumpRunQueue(void);
+void dumpProcess(process *p);
+process *nextInTree(process *proc, process *root);
+void zapMark(process *p, int *marked, int *mine, process **other);
+int zapMembers(int gid, process *root);
 
 /*
 
@@ -82,11 +330,51 @@ GLOBAL VARIABLES
 
 */
 
-process processTable[MAXPROC];
+process **processChunks = NULL;   // the process table, CHUNK_SIZE slots per chunk
+int numChunks = 0;
+int chunkCapacity = 0;
+process *freeList = NULL;          // EMPTY slots of the process table
+process **pidMap = NULL;           // live process with pid p is at pidMap[p % pidMapSize]
+int pidMapSize = 0;
+uint64_t *freeMapSlots = NULL;     // bit set for every empty pidMap entry
 process *currentProcess;
 int currentPid = 2;     
 int numberOfProcesses = 0;
-RunQueue run_queues[6]; 
+process *reapAfterSwitch = NULL;  // a detached process that quit, freed by the next context switch
+WorkerPool pools[MAXPOOLS];
+StackPool stackPools[STACK_CLASSES];
+int stackPoolHits = 0;
+int stackPoolMisses = 0;
+int dispatchCount = 0;
+int dispatchFastPath = 0;  // dispatches where the running process just kept running
+int dispatchHandoffs = 0;  // unblockAndSwitch() calls that went straight to the woken process
+int dumpStats = 0;      // DUMP_* flags, the statistics dumpProcesses() also prints
+RunQueue run_queues[NUM_LEVELS]; 
+uint64_t readyBitmap = 0;   // bit i is set when run_queues[i] is non-empty
+int schedPolicy = SCHED_FIXED;
+
+// the scheduling policies, indexed by SCHED_*
+SchedOps schedPolicies[] = {
+    { "fixed", rqEnqueue, rqDequeue, rqPickNext, rqKeepsRunning, schedNop, schedNop, schedNop },
+    { "mlfq", rqEnqueue, rqDequeue, rqPickNext, rqKeepsRunning, mlfqTick, mlfqPromote, schedNop },
+    { "fair", fairEnqueue, fairDequeue, fairPickNext, fairKeepsRunning, schedNop, schedNop, fairWake },
+};
+#define NUM_POLICIES (int)(sizeof(schedPolicies) / sizeof(schedPolicies[0]))
+SchedOps *schedOps = &schedPolicies[SCHED_FIXED];
+
+// runs when nothing else is ready, it has no pid and is never queued
+process idleProcess;
+processCold idleCold;
+int lastBoost = 0;          // currentTime() of the last MLFQ boost
+int priorityInheritance = 0;  // zap() and joinPid() lend their level to the target
+int agingPeriod = 0;        // a waiting process moves up a priority this often, 0 for never
+int nextAging = 0;          // no queued process moves up by aging before this time
+process **fairHeap = NULL;  // SCHED_FAIR: ready processes, least vruntime first
+int fairHeapSize = 0;
+int64_t fairClock = 0;      // SCHED_FAIR: least vruntime of the running and ready processes, only goes up
+process *edfHead = NULL;    // ready real-time processes, earliest deadline first
+process *rtList = NULL;     // all real-time processes
+int rtUtilization = 0;      // millionths of the cpu promised to real-time processes
 
 
 /**
@@ -143,10 +431,14 @@ void init_main() {
 
     dispatcher();
 
-    // Wait for all child processes to finish 
+    // Wait for all child processes to finish, the simulation is over
+    // once testcase_main has been reaped
     while (1) {
         int status;
         int joined_pid = join(&status);
+        if (joined_pid == test_pid) {
+            USLOSS_Halt(1);
+        }
         if (joined_pid == -2) {
             USLOSS_Console("Phase 1A TEMPORARY HACK: testcase_main() returned, simulation will now halt.\n");
             USLOSS_Halt(1);
@@ -155,40 +447,70 @@ void init_main() {
 
 }
 
+/*
+This is the idle process. It waits for interrupts, which is where anything
+that wakes a process comes from, and halts if nothing can ever wake one.
+*/
+void idle_main() {
+    enableInterrupts();
+    while (1) {
+        // with no device requests out and no real-time process waiting
+        // for its next period, every process is blocked for good
+        if (phase2_check_io() == 0 && !rtWaiting()) {
+            USLOSS_Console("DEADLOCK DETECTED!  All of the processes have blocked, but I/O is not ongoing.\n");
+            USLOSS_Halt(1);
+        }
+        USLOSS_WaitInt();
+    }
+}
+
 /**
 Initaizes the values
 */
 void phase1_init(void){
-    for(int i = 0 ; i < MAXPROC; i++){
-        processTable[i].pid = -1;
-        processTable[i].state = EMPTY;
-        processTable[i].parent = NULL;
-        processTable[i].first_child = NULL;
-        processTable[i].next_sibling = NULL;
-        processTable[i].stack = NULL;
-        processTable[i].exit_status = -1;
-        processTable[i].nextZap = NULL;
-        processTable[i].zapList = NULL;
-        processTable[i].timeUsed = 0;
-        
-    }
-    for (int i = 0; i < 6; i++) {
+    // the table starts with room for MAXPROC processes and grows from there
+    while (numChunks * CHUNK_SIZE < MAXPROC) {
+        if (growProcessTable() == -1) {
+            USLOSS_Console("ERROR: Memory allocation failed for the process table.\n");
+            USLOSS_Halt(1);
+        }
+    }
+    if (growPidMap() == -1) {
+        USLOSS_Console("ERROR: Memory allocation failed for the pid map.\n");
+        USLOSS_Halt(1);
+    }
+    for (int i = 0; i < NUM_LEVELS; i++) {
         run_queues[i].head = NULL;
         run_queues[i].tail = NULL;
     }
+    readyBitmap = 0;
+
+    // fill the pool with a few of the smallest stacks
+    for (int i = 0; i < STACK_CLASSES; i++) {
+        stackPools[i].head = NULL;
+        stackPools[i].count = 0;
+    }
+    for (int i = 0; i < STACK_POOL_PREWARM; i++) {
+        void *stack = mapStack(USLOSS_MIN_STACK);
+        if (stack != NULL) {
+            freeStack(stack, USLOSS_MIN_STACK);
+        }
+    }
 
     // create the init process
-    int index = 1 % MAXPROC;
-    process *new_proc = &processTable[index];
+    process *new_proc = allocProcess();
+    pidMap[1 % pidMapSize] = new_proc;
+    markSlot(1 % pidMapSize, 0);
 
     new_proc->pid = 1; 
     new_proc->priority = 6;
+    new_proc->level = priorityToLevel(new_proc->priority);
     new_proc->state = READY;
     new_proc->exit_status = 0;
-    strncpy(new_proc->name, "init", MAXNAME);
+    strncpy(new_proc->cold->name, "init", MAXNAME);
     new_proc->startFunc = (int (*)(void *)) init_main; 
     new_proc->arg = NULL;
-    new_proc->stack = malloc(USLOSS_MIN_STACK);
+    new_proc->stack = allocStack(USLOSS_MIN_STACK, &new_proc->stackSize);
 
     // error checks
     if (new_proc->stack == NULL) {
@@ -201,10 +523,26 @@ void phase1_init(void){
     }
 
     // initialze new context and enqueue proc
-    USLOSS_Context *oneContextPtr = &processTable[index].context;
-    USLOSS_ContextInit(oneContextPtr, new_proc->stack, USLOSS_MIN_STACK, NULL, (void (*)(void))init_main);
+    USLOSS_Context *oneContextPtr = &new_proc->cold->context;
+    USLOSS_ContextInit(oneContextPtr, new_proc->stack, new_proc->stackSize, NULL, (void (*)(void))init_main);
     enqueue(new_proc);
     numberOfProcesses+=1;
+
+    // the idle process is not in the process table, so it takes no pid
+    initSlot(&idleProcess);
+    idleProcess.cold = &idleCold;
+    idleProcess.pid = 0;
+    idleProcess.priority = LOWEST_PRIORITY + 2;
+    idleProcess.level = NUM_LEVELS - 1;
+    idleProcess.state = READY;
+    strncpy(idleProcess.cold->name, "idle", MAXNAME);
+    idleProcess.stackSize = USLOSS_MIN_STACK;
+    idleProcess.stack = mapStack(idleProcess.stackSize);
+    if (idleProcess.stack == NULL) {
+        USLOSS_Console("ERROR: Memory allocation failed for the idle process.\n");
+        USLOSS_Halt(1);
+    }
+    USLOSS_ContextInit(&idleProcess.cold->context, idleProcess.stack, idleProcess.stackSize, NULL, idle_main);
 }
 
 
@@ -213,7 +551,7 @@ This function creates a child process of the current process and returns the pid
 */
 int spork(char *name, int(*func)(void *), void *arg, int stacksize, int priority){
 
-    //USLOSS_Console("[DEBUG] spork() called by PID %d (%s)", currentProcess->pid, currentProcess->name);
+    //USLOSS_Console("[DEBUG] spork() called by PID %d (%s)", currentProcess->pid, currentProcess->cold->name);
     //USLOSS_Console("spork() creating child process with name: %s\n", name);
     // check if in user mode
     if (isKernel() != 1) {
@@ -221,36 +559,72 @@ int spork(char *name, int(*func)(void *), void *arg, int stacksize, int priority
         USLOSS_Halt(1);
     }
 
+    return sporkProcess(name, func, arg, stacksize, priority, 0, 0, 0);
+}
 
-    int psr = disableInterrupts();
+/**
+Like spork(), but the child is nobody's child: it can not be joined, the
+parent may quit before it, and quit() frees its pid, slot and stack.
+*/
+int sporkDetached(char *name, int(*func)(void *), void *arg, int stacksize, int priority){
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call sporkDetached while in user mode!\n");
+        USLOSS_Halt(1);
+    }
 
-    // find an empty slot of the child
-    int pid = -1;
-    process *childProcess = NULL;
-    for(int i = 0; i < MAXPROC; i++){
-        int candPid = currentPid;
-        int slot = currentPid % MAXPROC; 
-        if (processTable[slot].state == EMPTY) {
-            pid = candPid;
-            childProcess = &processTable[slot];
-            currentPid = (currentPid + 1);  
-            break;
-        }
-        currentPid++;
+    return sporkProcess(name, func, arg, stacksize, priority, 0, 0, 1);
+}
+
+/**
+Creates a real-time child process that gets budget microseconds of cpu every
+period microseconds, and must use them before the period ends. Returns -3 if
+the cpu can not promise that on top of the real-time processes there already are.
+*/
+int sporkRealtime(char *name, int(*func)(void *), void *arg, int stacksize, int period, int budget){
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call sporkRealtime while in user mode!\n");
+        USLOSS_Halt(1);
     }
 
-    // error check
-    if(childProcess == NULL){
+    return sporkProcess(name, func, arg, stacksize, 1, period, budget, 0);
+}
+
+/**
+Does the work of spork(), sporkDetached() and sporkRealtime(). period is 0
+for a process that is not real-time.
+*/
+int sporkProcess(char *name, int(*func)(void *), void *arg, int stacksize,
+                 int priority, int period, int budget, int detached){
+
+    int psr = disableInterrupts();
+
+    // find the first empty pid map entry at or after the one of the next
+    // pid, the map is doubled when it is full
+    int start = currentPid % pidMapSize;
+    int slot = findFreeSlot(start);
+    if (slot == -1 && growPidMap() == 0) {
+        start = currentPid % pidMapSize;
+        slot = findFreeSlot(start);
+    }
+    if (slot == -1) {
         restorePsr(psr);
         return -1;
     }
 
+    // the pid is used up even if the spork fails below
+    int pid = currentPid + (slot - start + pidMapSize) % pidMapSize;
+    currentPid = pid + 1;
+
     // check for valid parameters
     if (!name || !func) {
         restorePsr(psr);
         return -1;
     }
-    if (priority < 1 || priority > 5) {
+    if (priority < 1 || priority > LOWEST_PRIORITY) {
+        restorePsr(psr);
+        return -1;
+    }
+    if (period < 0 || (period > 0 && (budget <= 0 || budget > period))) {
         restorePsr(psr);
         return -1;
     }
@@ -259,27 +633,80 @@ int spork(char *name, int(*func)(void *), void *arg, int stacksize, int priority
         return -2;
     }
 
+    // admission control, the budgets may not promise more cpu than there is
+    int share = 0;
+    if (period > 0) {
+        share = (int)((int64_t)budget * 1000000 / period);
+        if (rtUtilization + share > RT_UTILIZATION_LIMIT) {
+            restorePsr(psr);
+            return -3;
+        }
+    }
+
+    int stackSize;
+    void *stack = allocStack(stacksize, &stackSize);
+    if (stack == NULL) {
+        restorePsr(psr);
+        return -1;
+    }
+
+    process *childProcess = allocProcess();
+    if (childProcess == NULL) {
+        freeStack(stack, stackSize);
+        restorePsr(psr);
+        return -1;
+    }
+    pidMap[slot] = childProcess;
+    markSlot(slot, 0);
+
     // add child to current parent process
     childProcess->pid = pid;
-    strncpy(childProcess->name, name, MAXNAME);            
+    strncpy(childProcess->cold->name, name, MAXNAME);            
     childProcess->priority = priority; 
+    childProcess->level = priorityToLevel(priority);
+    // the parent's cpu time up to now moves fairClock along
+    if (schedPolicy == SCHED_FAIR && currentProcess != NULL) {
+        chargeTime(currentProcess);
+    }
+    childProcess->vruntime = fairClock;
     childProcess->state = READY;
-    childProcess->parent = currentProcess;
-    childProcess->stack = malloc(stacksize);
+    childProcess->parent = detached ? NULL : currentProcess;
+    childProcess->gid = currentProcess->gid;
+    childProcess->detached = detached;
+    childProcess->stack = stack;
+    childProcess->stackSize = stackSize;
     childProcess->exit_status = -1;
     childProcess->startFunc = func;
     childProcess->arg = arg;
-    childProcess->next_sibling = currentProcess->first_child;
-    currentProcess->first_child = childProcess;
+    childProcess->timeUsed = 0;
+    childProcess->cpuTime = 0;
+    childProcess->next = NULL;
+    childProcess->prev = NULL;
+    if (period > 0) {
+        childProcess->period = period;
+        childProcess->budget = budget;
+        childProcess->deadline = currentTime() + period;
+        childProcess->nextRt = rtList;
+        rtList = childProcess;
+        rtUtilization += share;
+    }
+    if (!detached) {
+        childProcess->next_sibling = currentProcess->first_child;
+        if (currentProcess->first_child != NULL) {
+            currentProcess->first_child->prev_sibling = childProcess;
+        }
+        currentProcess->first_child = childProcess;
+    }
     numberOfProcesses+=1;
 
     // create context
-    USLOSS_ContextInit(&childProcess->context, childProcess->stack, stacksize, NULL, wrapper);
+    USLOSS_ContextInit(&childProcess->cold->context, childProcess->stack, childProcess->stackSize, NULL, wrapper);
     
     // enqueue the new process
     enqueue(childProcess);
 
-    if (childProcess->priority < currentProcess->priority) {        
+    if (period > 0 ? !keepsRunning(currentProcess) :
+        childProcess->priority < currentProcess->priority) {
         currentProcess->state = READY;
         enqueue(currentProcess);
         dispatcher();
@@ -290,362 +717,1815 @@ int spork(char *name, int(*func)(void *), void *arg, int stacksize, int priority
 }
 
 /**
-Removes a child from the parent's list.
+Adds a chunk of CHUNK_SIZE empty slots to the process table.
+Returns -1 if there is no memory for it.
 */
-void removeChild(process *parent, process *child) {
+int growProcessTable(void) {
+    if (numChunks == chunkCapacity) {
+        int capacity = (chunkCapacity == 0) ? 4 : chunkCapacity * 2;
+        process **chunks = realloc(processChunks, capacity * sizeof(process *));
+        if (chunks == NULL) {
+            return -1;
+        }
+        processChunks = chunks;
+        chunkCapacity = capacity;
+    }
 
-    if (!parent || !child) {
-        return;
+    // everything is allocated before the chunk is added, so a failure leaves
+    // the table as it was
+    process *chunk = malloc(CHUNK_SIZE * sizeof(process));
+    processCold *coldChunk = malloc(CHUNK_SIZE * sizeof(processCold));
+    if (chunk == NULL || coldChunk == NULL) {
+        free(chunk);
+        free(coldChunk);
+        return -1;
     }
 
-    if (parent->first_child == child) {
-        parent->first_child = child->next_sibling;
-    } else {
-        process *prev = parent->first_child;
-        while (prev && prev->next_sibling != child) {
-            prev = prev->next_sibling;
-        }
-        if (prev) {
-            prev->next_sibling = child->next_sibling;
-        }
+    // the fair heap always has room for the whole table
+    process **heap = realloc(fairHeap, (numChunks + 1) * CHUNK_SIZE * sizeof(process *));
+    if (heap == NULL) {
+        free(chunk);
+        free(coldChunk);
+        return -1;
     }
+    fairHeap = heap;
+    processChunks[numChunks++] = chunk;
+
+    // push backwards so that the first slot of the chunk is used first
+    for (int i = CHUNK_SIZE - 1; i >= 0; i--) {
+        chunk[i].cold = &coldChunk[i];
+        initSlot(&chunk[i]);
+        chunk[i].next = freeList;
+        freeList = &chunk[i];
+    }
+    return 0;
+}
+
+/**
+Resets a slot of the process table to EMPTY.
+*/
+void initSlot(process *proc) {
+    proc->pid = -1;
+    proc->state = EMPTY;
+    proc->parent = NULL;
+    proc->first_child = NULL;
+    proc->next_sibling = NULL;
+    proc->prev_sibling = NULL;
+    proc->zombieHead = NULL;
+    proc->zombieTail = NULL;
+    proc->nextZombie = NULL;
+    proc->prevZombie = NULL;
+    proc->joinTarget = NULL;
+    proc->zapTarget = NULL;
+    proc->groupZapper = NULL;
+    proc->zapPending = 0;
+    proc->gid = 0;
+    proc->detached = 0;
+    proc->inheritLevel = NUM_LEVELS;
+    proc->ageBoost = 0;
+    proc->readySince = 0;
+    proc->maxWait = 0;
+    proc->stack = NULL;
+    proc->stackSize = 0;
+    proc->exit_status = -1;
+    proc->zappers.head = NULL;
+    proc->zappers.tail = NULL;
+    proc->childWait.head = NULL;
+    proc->childWait.tail = NULL;
+    proc->waitingOn = NULL;
+    proc->nextWaiter = NULL;
+    proc->prevWaiter = NULL;
+    proc->blockReason = 0;
+    proc->next = NULL;
+    proc->prev = NULL;
+    proc->timeUsed = 0;
+    proc->cpuTime = 0;
+    proc->sliceStart = 0;
+    proc->vruntime = 0;
+    proc->heapIndex = -1;
+    proc->period = 0;
+    proc->budget = 0;
+    proc->budgetUsed = 0;
+    proc->deadline = 0;
+    proc->rtDone = 0;
+    proc->rtParked = 0;
+    proc->deadlineMisses = 0;
+    proc->nextRt = NULL;
+}
 
-    child->state = EMPTY;  
-    child->next_sibling = NULL;
-    child->parent = NULL;
-    child->pid = -1;
-    free(child->stack);
+/**
+Takes an empty slot off the free list, growing the table if there is none.
+Returns NULL if the table can not grow.
+*/
+process *allocProcess(void) {
+    if (freeList == NULL && growProcessTable() == -1) {
+        return NULL;
+    }
 
+    process *proc = freeList;
+    freeList = proc->next;
+    proc->next = NULL;
+    return proc;
 }
 
+/**
+Takes a process out of the pid map and puts its slot back on the free list.
+*/
+void freeProcess(process *proc) {
+    int slot = proc->pid % pidMapSize;
+    if (pidMap[slot] == proc) {
+        pidMap[slot] = NULL;
+        markSlot(slot, 1);
+    }
+
+    initSlot(proc);
+    proc->next = freeList;
+    freeList = proc;
+}
 
 /**
-Blocks the current process until one of its children terminates
+Finds the live process with a pid, or NULL if there is none.
 */
-int join(int *status){
-    // check user mode
-    if (isKernel() != 1){
-        USLOSS_Halt(1);
+process *findProcess(int pid) {
+    if (pid < 0) {
+        return NULL;
     }
+    process *proc = pidMap[pid % pidMapSize];
+    if (proc == NULL || proc->pid != pid) {
+        return NULL;
+    }
+    return proc;
+}
 
-    // checks for valid status
-    if (!status) {
-        return -3;
+/**
+Finds the first empty pid map entry at or after start, wrapping around to
+the beginning of the map. Returns -1 if the map is full.
+*/
+int findFreeSlot(int start) {
+    int words = (pidMapSize + 63) / 64;
+
+    // the part of the start word at or after start
+    int word = start / 64;
+    uint64_t bits = freeMapSlots[word] & (~0ULL << (start % 64));
+
+    // every word once, then the start word again for the bits before start
+    for (int i = 0; i <= words; i++) {
+        if (bits != 0) {
+            return word * 64 + __builtin_ctzll(bits);
+        }
+        word = (word + 1) % words;
+        bits = freeMapSlots[word];
     }
+    return -1;
+}
 
-    // no children
-    if (currentProcess->first_child == NULL) {
-        return -2;
+/**
+Marks an entry of the pid map as free or used.
+*/
+void markSlot(int slot, int free) {
+    if (free) {
+        freeMapSlots[slot / 64] |= 1ULL << (slot % 64);
+    } else {
+        freeMapSlots[slot / 64] &= ~(1ULL << (slot % 64));
     }
+}
 
-    int psr = disableInterrupts();
+/**
+Doubles the pid map (it starts with MAXPROC entries) and moves the live
+processes over. Two live pids that differ modulo the old size also differ
+modulo the new one, so they never collide. Returns -1 if there is no memory.
+*/
+int growPidMap(void) {
+    int size = (pidMapSize == 0) ? MAXPROC : pidMapSize * 2;
+    int words = (size + 63) / 64;
+    process **map = calloc(size, sizeof(process *));
+    uint64_t *freeBits = malloc(words * sizeof(uint64_t));
+    if (map == NULL || freeBits == NULL) {
+        free(map);
+        free(freeBits);
+        return -1;
+    }
 
-    process *curr = currentProcess->first_child; 
+    process **oldMap = pidMap;
+    int oldSize = pidMapSize;
+    uint64_t *oldFreeBits = freeMapSlots;
 
-    //check for terminated children
-    while (curr != NULL) {
-        if (curr->state == FINISHED || curr->state == QUIT) {
-            *status = curr->exit_status; 
-            int pid = curr->pid;
+    pidMap = map;
+    pidMapSize = size;
+    freeMapSlots = freeBits;
+    for (int i = 0; i < words; i++) {
+        freeMapSlots[i] = 0;
+    }
+    for (int i = 0; i < size; i++) {
+        markSlot(i, 1);
+    }
 
-            removeChild(currentProcess, curr);
-            numberOfProcesses--;
-            restorePsr(psr);
-            return pid;  
+    for (int i = 0; i < oldSize; i++) {
+        if (oldMap[i] != NULL) {
+            int slot = oldMap[i]->pid % pidMapSize;
+            pidMap[slot] = oldMap[i];
+            markSlot(slot, 0);
         }
-        curr = curr->next_sibling;
     }
-     // No terminated children found, so block the current process
-     currentProcess->state = BLOCKED;
-
-     // Call the dispatcher to switch to another process
-     dispatcher();
- 
-     // check again for terminated children
-     curr = currentProcess->first_child;
-     while (curr != NULL) {
-         if (curr->state == FINISHED || curr->state == QUIT) {
-             // Found a terminated child
-             *status = curr->exit_status;
-             int pid = curr->pid;
- 
-             // Remove the child from the parent's list
-             removeChild(currentProcess, curr);
-             numberOfProcesses--;
- 
-             // Restore interrupts and return the child's PID
-             restorePsr(psr);
-             return pid;
-         }
-         curr = curr->next_sibling;
-     }
- 
-    restorePsr(psr);
+    free(oldMap);
+    free(oldFreeBits);
+    return 0;
+}
 
-    // should not happen
-    return -2;
+/**
+Finds the stack class for a stack size, or -1 if the stack is too big to be pooled.
+*/
+int stackClass(int size) {
+    for (int i = 0; i < STACK_CLASSES; i++) {
+        if (size <= (USLOSS_MIN_STACK << i)) {
+            return i;
+        }
+    }
+    return -1;
 }
 
-void quit(int status){
-    
-    //USLOSS_Console("[DEBUG] quit() called by PID %d (%s)\n", currentProcess->pid, currentProcess->name);
-    
-    if(isKernel() != 1){
-        USLOSS_Console("ERROR: Someone attempted to call quit while in user mode!\n");
-        USLOSS_Halt(1);
+/**
+Gets a stack of at least size bytes, from the pool if it has one. The size
+that was really allocated is stored in allocSize. Returns NULL if there is no memory.
+*/
+void *allocStack(int size, int *allocSize) {
+    int class = stackClass(size);
+    if (class == -1) {
+        stackPoolMisses++;
+        int pageSize = getpagesize();
+        *allocSize = (size + pageSize - 1) / pageSize * pageSize;
+        return mapStack(*allocSize);
     }
-    
-    process *curr = currentProcess;
-    
-    // check if the current process has children 
-    
-    if (curr->first_child != NULL) {
-        USLOSS_Console("ERROR: Process pid %d called quit() while it still had children.\n", curr->pid);
-        USLOSS_Halt(1);
+
+    *allocSize = USLOSS_MIN_STACK << class;
+    StackPool *pool = &stackPools[class];
+    if (pool->head == NULL) {
+        stackPoolMisses++;
+        return mapStack(*allocSize);
     }
 
-     // Store exit status
-     curr->exit_status = status;
-     curr->state = FINISHED;
+    stackPoolHits++;
+    void *stack = pool->head;
+    pool->head = *(void **)((char *)stack + *allocSize - sizeof(void *));
+    pool->count--;
+    return stack;
+}
 
-     //USLOSS_Console("[DEBUG] quit(): Process %d (%s) is quitting with status %d, state changed to %s \n", curr->pid, curr->name, status, curr->state == FINISHED ? "FINISHED" : "QUIT");
-     
-     // Wake up the parent 
-     if (curr->parent && curr->parent->state == BLOCKED) {
-        //USLOSS_Console("[DEBUG] quit(): Waking up parent PID %d\n", curr->parent->pid);
-        curr->parent->state = READY;
-        enqueue(curr->parent);  // Add parent back to the run queue
+/**
+Gives a stack back to the pool, or unmaps it if its class is full or it is too big.
+The pages of a pooled stack are given back to the host, so the next process that
+gets it starts with an untouched stack.
+*/
+void freeStack(void *stack, int size) {
+    if (stack == NULL) {
+        return;
     }
 
-     // Wake up all processes that zapped this process
-    process *zapper = curr->zapList;
-    while (zapper != NULL) {
-        zapper->state = READY;
-        enqueue(zapper);
-        zapper = zapper->nextZap;
+    int class = stackClass(size);
+    if (class == -1 || size != (USLOSS_MIN_STACK << class) ||
+        stackPools[class].count >= STACK_POOL_MAX) {
+        unmapStack(stack, size);
+        return;
     }
 
-    dispatcher();
+    madvise(stack, size, MADV_DONTNEED);
 
-    //this should never be reached
-    USLOSS_Halt(1);    
+    StackPool *pool = &stackPools[class];
+    *(void **)((char *)stack + size - sizeof(void *)) = pool->head;
+    pool->head = stack;
+    pool->count++;
 }
 
 /**
-Gets the current processes pid
+Maps a stack of size bytes (a multiple of the page size) with a guard page
+below it. Returns NULL if there is no memory.
 */
-int getpid(void){
-    return (currentProcess) ? currentProcess->pid : -1;
+void *mapStack(int size) {
+    int pageSize = getpagesize();
+    char *base = mmap(NULL, size + pageSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    if (mprotect(base, pageSize, PROT_NONE) != 0) {
+        munmap(base, size + pageSize);
+        return NULL;
+    }
+    return base + pageSize;
 }
 
 /**
-Prints the process table.
+Unmaps a stack made by mapStack(), with its guard page.
 */
-void dumpProcesses(void) {
-    USLOSS_Console(" PID  PPID  NAME              PRIORITY  STATE\n");
+void unmapStack(void *stack, int size) {
+    int pageSize = getpagesize();
+    munmap((char *)stack - pageSize, size + pageSize);
+}
 
-    for (int i = 0; i < MAXPROC; i++) {
-        process *p = &processTable[i];
-        if (p->state != EMPTY && p->pid != -1) {  
-            const char *state;
-            char stateBuff[45];
-
-            switch (p->state) {
-                case RUNNING:
-                    state = "Running";
-                    break;
-                case READY:
-                    state = "Runnable";
-                    break;
-                case QUIT:
-                case FINISHED:
-                    snprintf(stateBuff, sizeof(stateBuff), "Terminated(%d)", p->exit_status);
-                    state = stateBuff;
-                    break;
-                case BLOCKED:
-                    if (p->first_child != NULL && p -> zapList == NULL) {
-                        snprintf(stateBuff, sizeof(stateBuff), "Blocked(waiting for child to quit)");
-                    }
-                   if(p->zapList != NULL){
-                        snprintf(stateBuff, sizeof(stateBuff), "Blocked(waiting for zap target to quit)");
-                   }
-                   else{
-                    snprintf(stateBuff, sizeof(stateBuff), "Blocked(waiting for zap target to quit)");
-                   }
-                    state = stateBuff;
-                    break;
-                default:
-                    state = "UNKNOWN";
+/**
+Finds how many bytes of its stack a process has used, to the page. Stacks grow
+down and pages are only there once touched, so the lowest page that is there
+marks the deepest the stack has been.
+*/
+int stackUsed(process *proc) {
+    int pageSize = getpagesize();
+    int pages = proc->stackSize / pageSize;
+    unsigned char there[64];
+
+    for (int first = 0; first < pages; first += 64) {
+        int count = (pages - first < 64) ? pages - first : 64;
+        if (mincore((char *)proc->stack + first * pageSize, count * pageSize, there) != 0) {
+            return -1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (there[i] & 1) {
+                return proc->stackSize - (first + i) * pageSize;
             }
-            USLOSS_Console("%4d %5d  %-16s %4d      %s\n",
-                p->pid,
-                (p->parent == NULL) ? 0 : p->parent->pid,  
-                p->name,
-                p->priority,
-                state);
         }
     }
+    return 0;
 }
 
-/*
-this enable interrupts
+/**
+Picks the statistics printed by dumpProcesses(), DUMP_* flags or'ed together.
+Turning DUMP_DISPATCH on starts the dispatcher counts over.
 */
-int enableInterrupts() {
-
-    unsigned int old_psr = USLOSS_PsrGet();
-    unsigned int new_psr = old_psr | USLOSS_PSR_CURRENT_INT;
-    int result = USLOSS_PsrSet(new_psr);
-    if(result != 0){
-        USLOSS_Console("ERROR: Failed to set PSR in enableInterrupts\n");
-        USLOSS_Halt(1);
+void setDumpStats(int flags) {
+    if ((flags & DUMP_DISPATCH) && !(dumpStats & DUMP_DISPATCH)) {
+        dispatchCount = 0;
+        dispatchFastPath = 0;
+        dispatchHandoffs = 0;
     }
-    return old_psr;
+    dumpStats = flags;
 }
 
 /**
-This disable interrupts 
+Fills in the statistics of a process. Returns -1 if there is no process pid.
 */
-int  disableInterrupts() {
+int getProcStats(int pid, procStats *stats) {
+    int old_psr = disableInterrupts();
 
-    unsigned int old_psr = USLOSS_PsrGet();
-    unsigned int new_psr = old_psr & ~USLOSS_PSR_CURRENT_INT;
-    int result = USLOSS_PsrSet(new_psr);
-    if (result != 0) {
-        USLOSS_Console("ERROR: Failed to set PSR in disableInterrupts\n");
-        USLOSS_Halt(1);
+    process *proc = findProcess(pid);
+    if (proc == NULL) {
+        restorePsr(old_psr);
+        return -1;
     }
-    return old_psr;
+
+    stats->cpuTime = proc->cpuTime;
+    stats->maxWait = proc->maxWait;
+    stats->stackUsed = stackUsed(proc);
+    stats->stackSize = proc->stackSize;
+    stats->deadlineMisses = proc->deadlineMisses;
+
+    restorePsr(old_psr);
+    return 0;
 }
-/*
+
+/**
+Removes a child from the parent's list.
+*/
+void removeChild(process *parent, process *child) {
+
+    if (!parent || !child) {
+        return;
+    }
+
+    if (child->prev_sibling == NULL) {
+        parent->first_child = child->next_sibling;
+    } else {
+        child->prev_sibling->next_sibling = child->next_sibling;
+    }
+    if (child->next_sibling != NULL) {
+        child->next_sibling->prev_sibling = child->prev_sibling;
+    }
+
+    freeStack(child->stack, child->stackSize);
+    freeProcess(child);
+
+}
+
+
+/**
+Adds a terminated child to the parent's zombie list. The list is kept in
+the order join() reaps children, the most recently created (highest pid)
+first. Children usually terminate in or against creation order, so the
+head and tail are checked before the list is searched.
+*/
+void addZombie(process *parent, process *child) {
+    process *after = NULL;   // the zombie that goes before child
+
+    if (parent->zombieHead == NULL || child->pid > parent->zombieHead->pid) {
+        after = NULL;
+    } else if (child->pid < parent->zombieTail->pid) {
+        after = parent->zombieTail;
+    } else {
+        after = parent->zombieHead;
+        while (after->nextZombie != NULL && after->nextZombie->pid > child->pid) {
+            after = after->nextZombie;
+        }
+    }
+
+    child->prevZombie = after;
+    child->nextZombie = (after == NULL) ? parent->zombieHead : after->nextZombie;
+    if (after == NULL) {
+        parent->zombieHead = child;
+    } else {
+        after->nextZombie = child;
+    }
+    if (child->nextZombie == NULL) {
+        parent->zombieTail = child;
+    } else {
+        child->nextZombie->prevZombie = child;
+    }
+}
+
+/**
+Takes a child off the parent's zombie list.
+*/
+void removeZombie(process *parent, process *child) {
+    if (child->prevZombie == NULL) {
+        parent->zombieHead = child->nextZombie;
+    } else {
+        child->prevZombie->nextZombie = child->nextZombie;
+    }
+    if (child->nextZombie == NULL) {
+        parent->zombieTail = child->prevZombie;
+    } else {
+        child->nextZombie->prevZombie = child->prevZombie;
+    }
+    child->nextZombie = NULL;
+    child->prevZombie = NULL;
+}
+
+/**
+Blocks the current process until one of its children terminates
+*/
+int join(int *status){
+    // check user mode
+    if (isKernel() != 1){
+        USLOSS_Halt(1);
+    }
+
+    // checks for valid status
+    if (!status) {
+        return -3;
+    }
+
+    // no children
+    if (currentProcess->first_child == NULL) {
+        return -2;
+    }
+
+    int psr = disableInterrupts();
+
+    // No terminated children found, so block the current process
+    if (currentProcess->zombieHead == NULL) {
+        waitOn(&currentProcess->childWait, BLOCKED_JOIN);
+    }
+
+    // take the most recently created terminated child
+    process *child = currentProcess->zombieHead;
+    if (child == NULL) {
+        restorePsr(psr);
+
+        // should not happen
+        return -2;
+    }
+    int pid = reapChild(child, status);
+
+    // Restore interrupts and return the child's PID
+    restorePsr(psr);
+    return pid;
+}
+
+/**
+Blocks the current process until the child with the given pid terminates.
+Returns -2 if there is no such child.
+*/
+int joinPid(int pid, int *status){
+    if (isKernel() != 1){
+        USLOSS_Console("ERROR: Someone attempted to call joinPid while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+
+    // checks for valid status
+    if (!status) {
+        return -3;
+    }
+
+    int psr = disableInterrupts();
+
+    process *child = findProcess(pid);
+    if (child == NULL || child->parent != currentProcess) {
+        restorePsr(psr);
+        return -2;
+    }
+
+    // only the termination of this child wakes us up
+    while (child->state != FINISHED && child->state != QUIT) {
+        currentProcess->joinTarget = child;
+        inheritPriority(currentProcess, child);
+        waitOn(&currentProcess->childWait, BLOCKED_JOIN);
+    }
+    currentProcess->joinTarget = NULL;
+
+    pid = reapChild(child, status);
+    restorePsr(psr);
+    return pid;
+}
+
+/**
+Like join(), but never blocks. Returns 0 if no child has terminated yet.
+*/
+int tryJoin(int *status){
+    if (isKernel() != 1){
+        USLOSS_Console("ERROR: Someone attempted to call tryJoin while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+
+    // checks for valid status
+    if (!status) {
+        return -3;
+    }
+
+    // no children
+    if (currentProcess->first_child == NULL) {
+        return -2;
+    }
+
+    int psr = disableInterrupts();
+
+    int pid = 0;
+    if (currentProcess->zombieHead != NULL) {
+        pid = reapChild(currentProcess->zombieHead, status);
+    }
+
+    restorePsr(psr);
+    return pid;
+}
+
+/**
+Collects the exit status of a terminated child of the current process and
+frees its slot. Returns the pid of the child.
+*/
+int reapChild(process *child, int *status){
+    removeZombie(currentProcess, child);
+
+    *status = child->exit_status;
+    int pid = child->pid;
+
+    // Remove the child from the parent's list
+    removeChild(currentProcess, child);
+    numberOfProcesses--;
+    return pid;
+}
+
+void quit(int status){
+    
+    //USLOSS_Console("[DEBUG] quit() called by PID %d (%s)\n", currentProcess->pid, currentProcess->cold->name);
+    
+    if(isKernel() != 1){
+        USLOSS_Console("ERROR: Someone attempted to call quit while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+    
+    process *curr = currentProcess;
+    
+    // check if the current process has children 
+    
+    if (curr->first_child != NULL) {
+        USLOSS_Console("ERROR: Process pid %d called quit() while it still had children.\n", curr->pid);
+        USLOSS_Halt(1);
+    }
+
+    // a clock interrupt must not switch away from a process that is half way
+    // through quitting, it would never be switched back to
+    disableInterrupts();
+
+     // Store exit status
+     curr->exit_status = status;
+     curr->state = FINISHED;
+     curr->inheritLevel = NUM_LEVELS;
+     if (curr->period > 0) {
+         rtForget(curr);
+     }
+
+     //USLOSS_Console("[DEBUG] quit(): Process %d (%s) is quitting with status %d, state changed to %s \n", curr->pid, curr->cold->name, status, curr->state == FINISHED ? "FINISHED" : "QUIT");
+     
+     // Tell the parent
+     if (curr->parent) {
+        addZombie(curr->parent, curr);
+     }
+
+     // Nobody joins a detached process, its pid is free right away. The slot
+     // and stack are still in use until we switch away from them
+     if (curr->detached) {
+        int slot = curr->pid % pidMapSize;
+        pidMap[slot] = NULL;
+        markSlot(slot, 1);
+        numberOfProcesses--;
+
+        // the detached process that quit before us was switched away from by
+        // the switch to us, free it before its place is taken
+        if (reapAfterSwitch != NULL) {
+            freeStack(reapAfterSwitch->stack, reapAfterSwitch->stackSize);
+            freeProcess(reapAfterSwitch);
+        }
+        reapAfterSwitch = curr;
+     }
+
+     // Wake up the parent, unless it is waiting for another child in joinPid()
+     if (curr->parent && curr->parent->waitingOn == &curr->parent->childWait &&
+         (curr->parent->joinTarget == NULL || curr->parent->joinTarget == curr)) {
+        //USLOSS_Console("[DEBUG] quit(): Waking up parent PID %d\n", curr->parent->pid);
+        wakeUp(curr->parent);  // Add parent back to the run queue
+    }
+
+     // Wake up all processes that zapped this process as one batch, the
+     // dispatcher below makes a single decision for all of them
+    wakeWaiters(&curr->zappers, 1);
+     if (curr->groupZapper != NULL && --curr->groupZapper->zapPending == 0 &&
+         curr->groupZapper->state == BLOCKED) {
+        wakeUp(curr->groupZapper);
+    }
+
+    dispatcher();
+
+    //this should never be reached
+    USLOSS_Halt(1);    
+}
+
+/**
+Gets the current processes pid
+*/
+int getpid(void){
+    return (currentProcess) ? currentProcess->pid : -1;
+}
+
+/**
+Gets the total cpu time used by the current process, in microseconds
+*/
+int readtime(void){
+    if (currentProcess == NULL) {
+        return 0;
+    }
+    int psr = disableInterrupts();
+    chargeTime(currentProcess);
+    restorePsr(psr);
+    return currentProcess->cpuTime;
+}
+
+/**
+Prints the process table.
+*/
+void dumpProcesses(void) {
+    USLOSS_Console(" PID  PPID  NAME              PRIORITY  STATE\n");
+
+    // only the used entries of the pid map are visited
+    int words = (pidMapSize + 63) / 64;
+    for (int w = 0; w < words; w++) {
+        uint64_t used = ~freeMapSlots[w];
+        if (w == words - 1 && pidMapSize % 64 != 0) {
+            used &= (1ULL << (pidMapSize % 64)) - 1;
+        }
+        while (used != 0) {
+            dumpProcess(pidMap[w * 64 + __builtin_ctzll(used)]);
+            used &= used - 1;
+        }
+    }
+
+    if (dumpStats & DUMP_PROC_STATS) {
+        USLOSS_Console(" PID  CPU TIME  MAX WAIT  STACK USED  STACK SIZE  DEADLINE MISSES\n");
+        for (int w = 0; w < words; w++) {
+            uint64_t used = ~freeMapSlots[w];
+            if (w == words - 1 && pidMapSize % 64 != 0) {
+                used &= (1ULL << (pidMapSize % 64)) - 1;
+            }
+            while (used != 0) {
+                process *p = pidMap[w * 64 + __builtin_ctzll(used)];
+                used &= used - 1;
+                USLOSS_Console("%4d  %8d  %8d  %10d  %10d  %15d\n",
+                    p->pid, p->cpuTime, p->maxWait, stackUsed(p), p->stackSize, p->deadlineMisses);
+            }
+        }
+    }
+    if (dumpStats & DUMP_DISPATCH) {
+        USLOSS_Console("Dispatcher: %d calls, %d kept the running process, %d handoffs\n",
+            dispatchCount, dispatchFastPath, dispatchHandoffs);
+    }
+    if (dumpStats & DUMP_STACK_POOL) {
+        USLOSS_Console("Stack pool: %d hits, %d misses\n", stackPoolHits, stackPoolMisses);
+    }
+}
+
+/**
+Prints one row of the process table.
+*/
+void dumpProcess(process *p) {
+    if (p->state != EMPTY && p->pid != -1) {  
+        const char *state;
+        char stateBuff[45];
+
+        switch (p->state) {
+            case RUNNING:
+                state = "Running";
+                break;
+            case READY:
+                state = "Runnable";
+                break;
+            case QUIT:
+            case FINISHED:
+                snprintf(stateBuff, sizeof(stateBuff), "Terminated(%d)", p->exit_status);
+                state = stateBuff;
+                break;
+            case BLOCKED:
+                switch (p->blockReason) {
+                    case BLOCKED_JOB:
+                        state = "Blocked(waiting for a job)";
+                        break;
+                    case BLOCKED_JOIN:
+                        state = "Blocked(waiting for child to quit)";
+                        break;
+                    case BLOCKED_ZAP:
+                        state = "Blocked(waiting for zap target to quit)";
+                        break;
+                    case BLOCKED_PERIOD:
+                        state = "Blocked(waiting for next period)";
+                        break;
+                    default:
+                        snprintf(stateBuff, sizeof(stateBuff), "Blocked(%d)", p->blockReason);
+                        state = stateBuff;
+                }
+                break;
+            default:
+                state = "UNKNOWN";
+        }
+        USLOSS_Console("%4d %5d  %-16s %4d      %s\n",
+            p->pid,
+            (p->parent == NULL) ? 0 : p->parent->pid,  
+            p->cold->name,
+            p->priority,
+            state);
+    }
+}
+
+/*
+this enable interrupts
+*/
+int enableInterrupts() {
+
+    unsigned int old_psr = USLOSS_PsrGet();
+    unsigned int new_psr = old_psr | USLOSS_PSR_CURRENT_INT;
+    int result = USLOSS_PsrSet(new_psr);
+    if(result != 0){
+        USLOSS_Console("ERROR: Failed to set PSR in enableInterrupts\n");
+        USLOSS_Halt(1);
+    }
+    return old_psr;
+}
+
+/**
+This disable interrupts 
+*/
+int  disableInterrupts() {
+
+    unsigned int old_psr = USLOSS_PsrGet();
+    unsigned int new_psr = old_psr & ~USLOSS_PSR_CURRENT_INT;
+    int result = USLOSS_PsrSet(new_psr);
+    if (result != 0) {
+        USLOSS_Console("ERROR: Failed to set PSR in disableInterrupts\n");
+        USLOSS_Halt(1);
+    }
+    return old_psr;
+}
+/*
 This function is the dispatcher. It will be called when a process needs to be switched out.
+It is also called by the clock interrupt. A running process keeps the cpu until its time
+slice is used up or a higher priority process is ready, and when the slice is used up it
+only gives the cpu to processes of the same or higher priority.
+*/
+void dispatcher() {
+    //USLOSS_Console("[DEBUG] dispatcher(): Entering dispatcher.\n");
+    // Check if the current process is in kernel mode
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call dispatcher while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+
+    //USLOSS_Console("[DEBUG] Dispatcher called. Current process: %d\n", currentProcess ? currentProcess->pid : -1);
+    int old_psr = disableInterrupts();
+
+    if (currentProcess != NULL) {
+        chargeTime(currentProcess);
+    }
+    dispatchCount++;
+
+    schedOps->tick(currentProcess);
+
+    if (agingPeriod > 0) {
+        ageReadyProcesses(currentTime());
+    }
+
+    if (rtList != NULL) {
+        rtRelease(currentTime());
+
+        // a real-time process that used up its budget waits for its next
+        // period, budgets are only checked on clock interrupts so less than
+        // half a tick left counts as used up
+        if (currentProcess != NULL && currentProcess->state == RUNNING &&
+            currentProcess->period > 0 &&
+            currentProcess->budgetUsed + USLOSS_CLOCK_MS * 500 >= currentProcess->budget) {
+            currentProcess->state = BLOCKED;
+            currentProcess->blockReason = BLOCKED_PERIOD;
+            currentProcess->rtParked = 1;
+        }
+    }
+
+    // the running process keeps the CPU without going through the queues
+    if (currentProcess != NULL && currentProcess->state == RUNNING &&
+        keepsRunning(currentProcess)) {
+        // nobody to share with, so it starts a new slice
+        if (currentProcess->timeUsed >= TIME_SLICE) {
+            currentProcess->timeUsed = 0;
+        }
+        dispatchFastPath++;
+        restorePsr(old_psr);
+        return;
+    }
+
+    // put the running process back in its run queue, at the back if its
+    // time slice is used up so the next process of its level gets a turn
+    if (currentProcess != NULL && currentProcess->state == RUNNING) {
+        currentProcess->state = READY;
+        if (currentProcess == &idleProcess) {
+            // never queued, select_next_process() falls back on it
+        } else if (currentProcess->timeUsed >= TIME_SLICE) {
+            enqueue(currentProcess);
+        } else {
+            enqueueFront(currentProcess);
+        }
+    }
+
+    process *next_process = select_next_process();
+
+    //USLOSS_Console("[DEBUG] dispatcher(): Switching to PID %d (%s)\n", next_process->pid, next_process->cold->name);
+    if (next_process != currentProcess) {
+        context_switch(next_process, 0);
+    } else {
+        next_process->state = RUNNING;
+    }
+    restorePsr(old_psr);
+}
+/* Helper function that find the highest priority process in the run queue
+   and returns it. If no process is found, it returns the idle process.
+   The function also removes the process from the run queue.
+   */
+
+process *select_next_process() {
+
+    // real-time processes run before everything else
+    if (edfHead != NULL) {
+        process *next_process = edfHead;
+        edfRemove(next_process);
+        return next_process;
+    }
+
+ 
+    process *next_process = schedOps->pickNext();
+
+    // no runnable processes found
+    if (next_process == NULL) {
+        return &idleProcess;
+    }
+
+    // Remove the process from the head of the queue
+    removeFromRunQueue(next_process);
+
+    return next_process;
+} 
+
+/*
+helper function that maps a priority onto its run queue level
+*/
+int priorityToLevel(int priority) {
+    return (priority - 1) * LEVELS_PER_PRIORITY;
+}
+
+/*
+helper function for the level a process goes back to, the level of its
+priority or a better one it inherited
+*/
+int homeLevel(process *proc) {
+    int level = priorityToLevel(proc->priority);
+    return (proc->inheritLevel < level) ? proc->inheritLevel : level;
+}
+
+/*
+Priority inheritance: waiter is about to block until target quits, so target
+runs at least at waiter's level until then, and so does whatever target is
+waiting for in turn. In SCHED_FAIR target also catches up to waiter's
+virtual runtime. The lent level is dropped when target quits.
+Does nothing unless it was turned on with setPriorityInheritance().
+*/
+void inheritPriority(process *waiter, process *target) {
+    if (!priorityInheritance) {
+        return;
+    }
+
+    int level = waiter->level;
+    while (target != NULL && target->state != FINISHED && target->state != QUIT) {
+        // what target waits for already has a level this good
+        if (level >= target->inheritLevel) {
+            break;
+        }
+        target->inheritLevel = level;
+        if (level < target->level) {
+            setLevel(target, level);
+        }
+        if (inFairClass(waiter) && inFairClass(target) && waiter->vruntime < target->vruntime) {
+            target->vruntime = waiter->vruntime;
+            if (target->heapIndex >= 0) {
+                fairHeapUp(target->heapIndex);
+            }
+        }
+
+        target = (target->state != BLOCKED) ? NULL :
+                 (target->zapTarget != NULL) ? target->zapTarget : target->joinTarget;
+    }
+}
+
+/*
+Priority inheritance: works out again the level target was lent, from the
+processes waiting for it now: its zappers, a parent in joinPid() for it and
+the zapGroup() or zapTree() caller waiting for it. A level that went down
+only goes down as far as the target's own priority and what it got from
+aging. What target waits for in turn is worked out again after it.
+*/
+void recomputeInheritance(process *target) {
+    if (!priorityInheritance) {
+        return;
+    }
+
+    while (target != NULL && target->state != FINISHED && target->state != QUIT) {
+        int level = NUM_LEVELS;
+        for (process *w = target->zappers.head; w != NULL; w = w->nextWaiter) {
+            if (w->level < level) {
+                level = w->level;
+            }
+        }
+        process *parent = target->parent;
+        if (parent != NULL && parent->state == BLOCKED && parent->joinTarget == target &&
+            parent->level < level) {
+            level = parent->level;
+        }
+        if (target->groupZapper != NULL && target->groupZapper->state == BLOCKED &&
+            target->groupZapper->level < level) {
+            level = target->groupZapper->level;
+        }
+
+        // nothing changes for target, so nothing does further along either
+        if (level == target->inheritLevel) {
+            break;
+        }
+        target->inheritLevel = level;
+
+        level = homeLevel(target) - target->ageBoost;
+        if (level < 0) {
+            level = 0;
+        }
+        if (level != target->level) {
+            setLevel(target, level);
+        }
+
+        target = (target->state != BLOCKED) ? NULL :
+                 (target->zapTarget != NULL) ? target->zapTarget : target->joinTarget;
+    }
+}
+
+/*
+Aging: every process waiting in the run queues moves up a priority for every
+agingPeriod it has waited, up to priority 1. context_switch() puts it back.
+The fair and real-time classes do not starve, so they are not aged.
+A run queue is not in the order its processes became ready, enqueueFront()
+and setLevel() put older and newer ones anywhere, so the whole of every level
+is looked at. That is only done once nextAging has passed: the other
+dispatches cost one compare.
+*/
+void ageReadyProcesses(int now) {
+    if (now < nextAging) {
+        return;
+    }
+    nextAging = INT_MAX;
+
+    uint64_t levels = readyBitmap;
+    while (levels != 0) {
+        int i = __builtin_ctzll(levels);
+        levels &= levels - 1;
+
+        process *next;
+        for (process *p = run_queues[i].head; p != NULL; p = next) {
+            next = p->next;
+            if (p->priority > LOWEST_PRIORITY) {
+                continue;
+            }
+            int steps = (now - p->readySince) / agingPeriod;
+            int level = p->level + p->ageBoost - steps * LEVELS_PER_PRIORITY;
+            if (level < 0) {
+                level = 0;
+            }
+            if (level >= p->level) {
+                noteAging(p);
+                continue;
+            }
+            // the process goes to a better level, which was looked at already
+            p->ageBoost += p->level - level;
+            setLevel(p, level);
+        }
+    }
+}
+
+/*
+Aging: brings nextAging forward to when a queued process is next due to move up
+*/
+void noteAging(process *proc) {
+    if (agingPeriod == 0 || proc->period > 0 || proc->level == 0 ||
+        proc->priority > LOWEST_PRIORITY) {
+        return;
+    }
+    int due = proc->readySince + (proc->ageBoost / LEVELS_PER_PRIORITY + 1) * agingPeriod;
+    if (due < nextAging) {
+        nextAging = due;
+    }
+}
+
+/**
+Turns aging on, a process waiting in the run queues moves up a priority for
+every period microseconds it waits. 0 turns it off, which is the default.
+*/
+void setAging(int period) {
+    agingPeriod = (period > 0) ? period : 0;
+    nextAging = 0;
+}
+
+/**
+Turns priority inheritance through zap() and joinPid() on or off. It is off
+by default, so a zapped or joined process runs at its own priority.
+*/
+void setPriorityInheritance(int enabled) {
+    priorityInheritance = enabled;
+}
+
+/**
+Changes the priority of a process. A ready process moves to the run queue of
+its new priority right away, and the dispatcher runs in case it now comes
+before the current process, or the current process put itself below a ready
+one. A blocked process is queued at its new priority when it wakes up, and
+if it is in zap() or joinPid() it lends the new priority to its target like
+it would have when it blocked, or takes back what it lent if the new
+priority is lower. The process loses what it got from aging and from MLFQ.
+Returns -1 if there is no such process, it is init or real-time, or the
+priority is not 1 to LOWEST_PRIORITY.
+*/
+int setPriority(int pid, int priority) {
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call setPriority while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+
+    int old_psr = disableInterrupts();
+
+    process *proc = findProcess(pid);
+    if (proc == NULL || proc->pid == 1 || proc->state == FINISHED || proc->state == QUIT ||
+        proc->period > 0 || priority < 1 || priority > LOWEST_PRIORITY) {
+        restorePsr(old_psr);
+        return -1;
+    }
+
+    proc->priority = priority;
+    proc->ageBoost = 0;
+    setLevel(proc, homeLevel(proc));
+
+    if (proc->state == BLOCKED) {
+        // what it lent to the processes it waits for may have to be taken back
+        process *target = (proc->zapTarget != NULL) ? proc->zapTarget : proc->joinTarget;
+        inheritPriority(proc, target);
+        recomputeInheritance(target);
+        if (proc->zapPending > 0) {
+            for (int i = 0; i < pidMapSize; i++) {
+                if (pidMap[i] != NULL && pidMap[i]->groupZapper == proc) {
+                    inheritPriority(proc, pidMap[i]);
+                    recomputeInheritance(pidMap[i]);
+                }
+            }
+        }
+    } else {
+        dispatcher();
+    }
+
+    restorePsr(old_psr);
+    return 0;
+}
+
+/*
+helper function that moves a process to another level, and to the back of
+that level's run queue if it is in one
+*/
+void setLevel(process *proc, int level) {
+    if (proc->level == level) {
+        return;
+    }
+    if (isQueued(proc)) {
+        // it has been waiting all along
+        int readySince = proc->readySince;
+        removeFromRunQueue(proc);
+        proc->level = level;
+        enqueue(proc);
+        proc->readySince = readySince;
+        noteAging(proc);
+    } else {
+        proc->level = level;
+    }
+}
+
+/*
+MLFQ: the process used a whole time slice, so it drops down
+*/
+void mlfqDemote(process *proc) {
+    int level = proc->level + MLFQ_STEP;
+    if (level > MLFQ_BOTTOM_LEVEL) {
+        level = MLFQ_BOTTOM_LEVEL;
+    }
+    // a process that inherited a level keeps it
+    if (level > proc->inheritLevel) {
+        level = proc->inheritLevel;
+    }
+    // init and anything else already below the bottom stays where it is
+    if (level > proc->level) {
+        setLevel(proc, level);
+    }
+}
+
+/*
+MLFQ: the process blocked before its time slice was up, so it climbs back up
+*/
+void mlfqPromote(process *proc) {
+    int level = proc->level - MLFQ_STEP;
+    if (level < homeLevel(proc)) {
+        level = homeLevel(proc);
+    }
+    setLevel(proc, level);
+}
+
+/*
+MLFQ: puts every process back at the level of its priority, or the one it inherited
+*/
+void mlfqBoost(void) {
+    int words = (pidMapSize + 63) / 64;
+    for (int w = 0; w < words; w++) {
+        uint64_t used = ~freeMapSlots[w];
+        if (w == words - 1 && pidMapSize % 64 != 0) {
+            used &= (1ULL << (pidMapSize % 64)) - 1;
+        }
+        while (used != 0) {
+            process *p = pidMap[w * 64 + __builtin_ctzll(used)];
+            used &= used - 1;
+            p->ageBoost = 0;
+            setLevel(p, homeLevel(p));
+        }
+    }
+    lastBoost = currentTime();
+}
+
+/*
+MLFQ: called on every dispatch, boosts everybody once a period and drops the
+running process down when its time slice is used up
 */
-void dispatcher() {
-    //USLOSS_Console("[DEBUG] dispatcher(): Entering dispatcher.\n");
-    // Check if the current process is in kernel mode
-    if (isKernel() != 1) {
-        USLOSS_Console("ERROR: Someone attempted to call dispatcher while in user mode!\n");
-        USLOSS_Halt(1);
+void mlfqTick(process *proc) {
+    if (currentTime() - lastBoost >= MLFQ_BOOST_PERIOD) {
+        mlfqBoost();
     }
-    if (currentProcess != NULL && currentProcess->state == RUNNING) {
-        currentProcess->state = READY;
+    if (proc != NULL && proc->state == RUNNING && proc->timeUsed >= TIME_SLICE) {
+        mlfqDemote(proc);
     }
+}
 
-    //USLOSS_Console("[DEBUG] Dispatcher called. Current process: %d\n", currentProcess ? currentProcess->pid : -1);
+/**
+Picks the scheduling policy, SCHED_FIXED, SCHED_MLFQ or SCHED_FAIR. Every
+process goes back to the level of its priority, and the ready ones are moved
+to where the new policy keeps them.
+*/
+void setSchedPolicy(int policy) {
+    if (policy < 0 || policy >= NUM_POLICIES) {
+        return;
+    }
     int old_psr = disableInterrupts();
+    mlfqBoost();
+
+    // take the ready processes out with the old policy, chained through
+    // next in pid map order, and put them back with the new one
+    process *moved = NULL;
+    process *movedTail = NULL;
+    int words = (pidMapSize + 63) / 64;
+    for (int w = 0; w < words; w++) {
+        uint64_t used = ~freeMapSlots[w];
+        if (w == words - 1 && pidMapSize % 64 != 0) {
+            used &= (1ULL << (pidMapSize % 64)) - 1;
+        }
+        while (used != 0) {
+            process *p = pidMap[w * 64 + __builtin_ctzll(used)];
+            used &= used - 1;
+            p->vruntime = fairClock;
+            if (isQueued(p) && p->period == 0) {
+                removeFromRunQueue(p);
+                if (movedTail == NULL) {
+                    moved = p;
+                } else {
+                    movedTail->next = p;
+                }
+                movedTail = p;
+            }
+        }
+    }
 
-    process *next_process = select_next_process();
+    schedPolicy = policy;
+    schedOps = &schedPolicies[policy];
 
-    //USLOSS_Console("[DEBUG] dispatcher(): Switching to PID %d (%s)\n", next_process->pid, next_process->name);
-    if (next_process != currentProcess) {
-        context_switch(next_process);
+    while (moved != NULL) {
+        process *next = moved->next;
+        moved->next = NULL;
+        enqueue(moved);
+        moved = next;
     }
     restorePsr(old_psr);
 }
-/* Helper function that find the highest priority process in the run queue
-   and returns it. If no process is found, it will return NULL.
-   The function also removes the process from the run queue.
-   */
 
-process *select_next_process() {
+/**
+Picks the scheduling policy by its name, "fixed", "mlfq" or "fair".
+Returns -1 if there is no policy with that name.
+*/
+int setSchedPolicyByName(char *name) {
+    for (int i = 0; i < NUM_POLICIES; i++) {
+        if (strcmp(schedPolicies[i].name, name) == 0) {
+            setSchedPolicy(i);
+            return 0;
+        }
+    }
+    return -1;
+}
 
-    // loop through all queues
-    for (int priority = 0; priority < 6; priority++) {
-        // check if the queue is empty
-        if (run_queues[priority].head != NULL) {
-            process *next_process = run_queues[priority].head;
+/**
+Reads the phase 1 options from the command line arguments USLOSS passes on to
+startup(). "-s <policy>" or "--sched=<policy>" picks the scheduling policy, so
+the same test can be run under each policy without rebuilding:
+    ./test37 -- --sched=mlfq
+Halts on an option it does not know.
+*/
+void phase1_options(int argc, char **argv) {
+    for (int i = 0; i < argc; i++) {
+        char *policy = NULL;
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            policy = argv[++i];
+        } else if (strncmp(argv[i], "--sched=", 8) == 0) {
+            policy = argv[i] + 8;
+        } else {
+            USLOSS_Console("ERROR: unknown phase 1 option '%s'\n", argv[i]);
+            USLOSS_Halt(1);
+        }
 
-            // Remove the process from the head of the queue
-            run_queues[priority].head = next_process->next;
+        if (setSchedPolicyByName(policy) == -1) {
+            USLOSS_Console("ERROR: unknown scheduling policy '%s', it must be fixed, mlfq or fair\n", policy);
+            USLOSS_Halt(1);
+        }
+    }
+}
 
-            // If the queue is now empty, update the tail pointer
-            if (run_queues[priority].head == NULL) {
-                run_queues[priority].tail = NULL;
-            }
+/*
+Checks if the running process should keep the cpu: no real-time process with
+an earlier deadline is ready, and then no level above it has anything ready
+and, at its own level, it still has time left in its slice
+*/
+int keepsRunning(process *proc) {
+    if (proc == &idleProcess) {
+        return edfHead == NULL && schedOps->pickNext() == NULL;
+    }
+    if (proc->period > 0) {
+        return edfHead == NULL || proc->deadline <= edfHead->deadline;
+    }
+    if (edfHead != NULL) {
+        return 0;
+    }
+    return schedOps->keepsRunning(proc);
+}
+
+/*
+Makes a blocked process ready again
+*/
+void wakeUp(process *proc) {
+    if (proc->waitingOn != NULL) {
+        unlinkWaiter(proc);
+    }
+    proc->state = READY;
+    schedOps->wake(proc);
+    enqueue(proc);
+}
+
+/*
+Takes a blocked process off the wait queue it is on
+*/
+void unlinkWaiter(process *proc) {
+    waitQueue *queue = proc->waitingOn;
+    if (proc->prevWaiter != NULL) {
+        proc->prevWaiter->nextWaiter = proc->nextWaiter;
+    } else {
+        queue->head = proc->nextWaiter;
+    }
+    if (proc->nextWaiter != NULL) {
+        proc->nextWaiter->prevWaiter = proc->prevWaiter;
+    } else {
+        queue->tail = proc->prevWaiter;
+    }
+    proc->nextWaiter = NULL;
+    proc->prevWaiter = NULL;
+    proc->waitingOn = NULL;
+}
+
+/*
+Makes the oldest process of a wait queue ready, or all of them, without
+calling the dispatcher. Returns how many it woke.
+*/
+int wakeWaiters(waitQueue *queue, int all) {
+    int woken = 0;
+    while (queue->head != NULL) {
+        wakeUp(queue->head);
+        woken++;
+        if (!all) {
+            break;
+        }
+    }
+    return woken;
+}
 
-            // Clear the next pointer of the selected process
-            next_process->next = NULL;
+/*
+A hook of a policy that has nothing to do
+*/
+void schedNop(process *proc) {
+}
 
-            return next_process;
+/*
+Run queues: adds a ready process to the queue of its level
+*/
+void rqEnqueue(process *proc, int front) {
+    int level = proc->level;
+    if (front) {
+        proc->prev = NULL;
+        proc->next = run_queues[level].head;
+
+        if (run_queues[level].head == NULL) {
+            run_queues[level].tail = proc;
+            readyBitmap |= 1ULL << level;
+        } else {
+            run_queues[level].head->prev = proc;
+        }
+        run_queues[level].head = proc;
+    } else {
+        proc->next = NULL;
+        proc->prev = run_queues[level].tail;
+
+        // special case for empty head
+        if (run_queues[level].head == NULL) {
+            run_queues[level].head = proc;
+            readyBitmap |= 1ULL << level;
+        } else {
+            run_queues[level].tail->next = proc;
         }
+        run_queues[level].tail = proc;
     }
-    // No runnable processes found
-    //USLOSS_Console("[ERROR] No runnable processes found. Halting.\n");
-    USLOSS_Halt(1);
-    return NULL;
-} 
+}
+
+/*
+Run queues: takes a process out of the queue of its level
+*/
+void rqDequeue(process *proc) {
+    int level = proc->level;
+
+    // unlink from q
+    if (proc->prev == NULL) {
+        run_queues[level].head = proc->next;
+    } else {
+        proc->prev->next = proc->next;
+    }
+    if (proc->next == NULL) {
+        run_queues[level].tail = proc->prev;
+    } else {
+        proc->next->prev = proc->prev;
+    }
+
+    if (run_queues[level].head == NULL) {
+        readyBitmap &= ~(1ULL << level);
+    }
+    proc->next = NULL;
+    proc->prev = NULL;
+}
+
+/*
+Run queues: the lowest set bit of readyBitmap is the best non-empty level
+*/
+process *rqPickNext(void) {
+    if (readyBitmap == 0) {
+        return NULL;
+    }
+    return run_queues[__builtin_ctzll(readyBitmap)].head;
+}
+
+/*
+Run queues: the running process keeps the cpu if no level above it has
+anything ready and, at its own level, it still has time left in its slice
+*/
+int rqKeepsRunning(process *proc) {
+    int best = (readyBitmap == 0) ? NUM_LEVELS : __builtin_ctzll(readyBitmap);
+    return proc->level < best || (proc->level == best && proc->timeUsed < TIME_SLICE);
+}
+
+/*
+SCHED_FAIR: init, and anything else below LOWEST_PRIORITY, still uses the run queues
+*/
+int inFairClass(process *proc) {
+    return schedPolicy == SCHED_FAIR && proc->priority <= LOWEST_PRIORITY;
+}
+
+/*
+SCHED_FAIR: the weight of a priority, priority 3 has weight 4
+*/
+int fairWeight(int priority) {
+    return 1 << (LOWEST_PRIORITY - priority);
+}
+
+/*
+SCHED_FAIR: the fair class goes in the heap, the rest in the run queues
+*/
+void fairEnqueue(process *proc, int front) {
+    if (inFairClass(proc)) {
+        fairHeapInsert(proc);
+    } else {
+        rqEnqueue(proc, front);
+    }
+}
+
+/*
+SCHED_FAIR: takes a process out of the heap or its run queue
+*/
+void fairDequeue(process *proc) {
+    if (proc->heapIndex < 0) {
+        rqDequeue(proc);
+        return;
+    }
+    if (proc->heapIndex == 0 && proc->vruntime > fairClock) {
+        fairClock = proc->vruntime;
+    }
+    fairHeapRemove(proc);
+}
+
+/*
+SCHED_FAIR: the fair class runs before the run queues
+*/
+process *fairPickNext(void) {
+    return (fairHeapSize > 0) ? fairHeap[0] : rqPickNext();
+}
+
+/*
+SCHED_FAIR: the running process keeps the cpu until it is FAIR_GRANULARITY
+ahead of the ready process that is furthest behind
+*/
+int fairKeepsRunning(process *proc) {
+    if (!inFairClass(proc)) {
+        return fairHeapSize == 0 && rqKeepsRunning(proc);
+    }
+    return fairHeapSize == 0 || proc->vruntime < fairHeap[0]->vruntime + FAIR_GRANULARITY;
+}
+
+/*
+SCHED_FAIR: moves fairClock up to the least vruntime of the running process
+and the ready ones. It moves while a process runs alone too, so a process
+that is sporked or wakes up after that starts level with it and not far behind
+*/
+void fairAdvanceClock(void) {
+    int64_t least = INT64_MAX;
+    if (currentProcess != NULL && currentProcess->state == RUNNING && inFairClass(currentProcess)) {
+        least = currentProcess->vruntime;
+    }
+    if (fairHeapSize > 0 && fairHeap[0]->vruntime < least) {
+        least = fairHeap[0]->vruntime;
+    }
+    if (least != INT64_MAX && least > fairClock) {
+        fairClock = least;
+    }
+}
+
+/*
+SCHED_FAIR: a process that has been blocked for a long time is brought up
+close to fairClock so that it can not hog the cpu to catch up
+*/
+void fairWake(process *proc) {
+    if (inFairClass(proc) && proc->vruntime < fairClock - FAIR_WAKE_CREDIT) {
+        proc->vruntime = fairClock - FAIR_WAKE_CREDIT;
+    }
+}
+
+/*
+Adds a ready real-time process to the EDF queue, after the ones with the same deadline
+*/
+void edfInsert(process *proc) {
+    process *prev = NULL;
+    process *curr = edfHead;
+    while (curr != NULL && curr->deadline <= proc->deadline) {
+        prev = curr;
+        curr = curr->next;
+    }
+
+    proc->prev = prev;
+    proc->next = curr;
+    if (prev == NULL) {
+        edfHead = proc;
+    } else {
+        prev->next = proc;
+    }
+    if (curr != NULL) {
+        curr->prev = proc;
+    }
+}
+
+/*
+Takes a real-time process out of the EDF queue
+*/
+void edfRemove(process *proc) {
+    if (proc->prev == NULL) {
+        edfHead = proc->next;
+    } else {
+        proc->prev->next = proc->next;
+    }
+    if (proc->next != NULL) {
+        proc->next->prev = proc->prev;
+    }
+    proc->next = NULL;
+    proc->prev = NULL;
+}
+
+/*
+Starts a new period for every real-time process whose deadline has passed. A
+process that had not called waitPeriod() by then missed its deadline. A
+process that was waiting for the new period is made ready again.
+*/
+void rtRelease(int now) {
+    for (process *p = rtList; p != NULL; p = p->nextRt) {
+        if (now < p->deadline) {
+            continue;
+        }
+        if (!p->rtDone) {
+            p->deadlineMisses++;
+        }
+        while (p->deadline <= now) {
+            p->deadline += p->period;
+        }
+        p->budgetUsed = 0;
+        p->rtDone = 0;
+
+        if (p->rtParked) {
+            p->rtParked = 0;
+            p->state = READY;
+            enqueue(p);
+        } else if (isQueued(p)) {
+            // its deadline moved, so its place in the queue did too
+            edfRemove(p);
+            edfInsert(p);
+        }
+    }
+}
+
+/*
+Returns 1 if a real-time process is waiting for its next period, which the
+clock will start, and 0 if none is
+*/
+int rtWaiting(void) {
+    for (process *p = rtList; p != NULL; p = p->nextRt) {
+        if (p->rtParked) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+Takes a real-time process that is quitting off rtList and gives its budget back
+*/
+void rtForget(process *proc) {
+    process **link = &rtList;
+    while (*link != proc) {
+        link = &(*link)->nextRt;
+    }
+    *link = proc->nextRt;
+    rtUtilization -= (int)((int64_t)proc->budget * 1000000 / proc->period);
+}
+
+/**
+Ends the current period of a real-time process. It waits for the next one
+to start. Returns -1 if the current process is not real-time.
+*/
+int waitPeriod(void) {
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call waitPeriod while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+    if (currentProcess->period == 0) {
+        return -1;
+    }
+
+    int old_psr = disableInterrupts();
+    currentProcess->rtDone = 1;
+    currentProcess->rtParked = 1;
+    currentProcess->state = BLOCKED;
+    currentProcess->blockReason = BLOCKED_PERIOD;
+    dispatcher();
+    restorePsr(old_psr);
+    return 0;
+}
+
+/*
+SCHED_FAIR: moves the process at index i of the heap up to its place
+*/
+void fairHeapUp(int i) {
+    process *proc = fairHeap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (fairHeap[parent]->vruntime <= proc->vruntime) {
+            break;
+        }
+        fairHeap[i] = fairHeap[parent];
+        fairHeap[i]->heapIndex = i;
+        i = parent;
+    }
+    fairHeap[i] = proc;
+    proc->heapIndex = i;
+}
+
+/*
+SCHED_FAIR: moves the process at index i of the heap down to its place
+*/
+void fairHeapDown(int i) {
+    process *proc = fairHeap[i];
+    while (2 * i + 1 < fairHeapSize) {
+        int child = 2 * i + 1;
+        if (child + 1 < fairHeapSize && fairHeap[child + 1]->vruntime < fairHeap[child]->vruntime) {
+            child++;
+        }
+        if (proc->vruntime <= fairHeap[child]->vruntime) {
+            break;
+        }
+        fairHeap[i] = fairHeap[child];
+        fairHeap[i]->heapIndex = i;
+        i = child;
+    }
+    fairHeap[i] = proc;
+    proc->heapIndex = i;
+}
+
+/*
+SCHED_FAIR: adds a ready process to the heap
+*/
+void fairHeapInsert(process *proc) {
+    fairHeap[fairHeapSize] = proc;
+    fairHeapUp(fairHeapSize++);
+}
+
+/*
+SCHED_FAIR: takes a process out of the heap
+*/
+void fairHeapRemove(process *proc) {
+    int i = proc->heapIndex;
+    proc->heapIndex = -1;
+    fairHeapSize--;
+    if (i == fairHeapSize) {
+        return;
+    }
+    fairHeap[i] = fairHeap[fairHeapSize];
+    fairHeap[i]->heapIndex = i;
+    fairHeapUp(i);
+    fairHeapDown(fairHeap[i]->heapIndex);
+}
 
 /*
 helper function to enqueue the process into the run queue
 */
 void enqueue(process *proc) {
 
-   // Enqueuing process %d (%s) in priority queue %d\n", proc->pid, proc->name, proc->priority);
-    int priority = proc->priority - 1; 
+   // Enqueuing process %d (%s) in priority queue %d\n", proc->pid, proc->cold->name, proc->priority);
+    int level = proc->level; 
     
     // eror check
-    if (priority < 0 || priority >= 6) {
+    if (level < 0 || level >= NUM_LEVELS) {
+        return;
+    }
+
+    // a process is never queued twice
+    if (isQueued(proc)) {
         return;
     }
+    proc->readySince = currentTime();
+    noteAging(proc);
 
-    // special case for empty head
-    if (run_queues[priority].head == NULL) {
-        run_queues[priority].head = proc;
-        run_queues[priority].tail = proc;
+    if (proc->period > 0) {
+        edfInsert(proc);
     } else {
-        run_queues[priority].tail->next = proc;
-        run_queues[priority].tail = proc;
+        schedOps->enqueue(proc, 0);
     }
-    //USLOSS_Console("[DEBUG] DUMPING QUEUSE AFter ENQUEUE\n");
-    proc->next = NULL;
 }
 /*
-helper function to remove a process from the run queue
+helper function to put a process at the front of its run queue
 */
-void removeFromRunQueue(process *proc) {
-    //USLOSS_Console("[DEBUG] Removing process %d (%s) from priority queue %d\n", proc->pid, proc->name, proc->priority);
-    int priority = proc->priority - 1; 
-    if (priority < 0 || priority >= 6) {
+void enqueueFront(process *proc) {
+
+    int level = proc->level;
+
+    // eror check
+    if (level < 0 || level >= NUM_LEVELS) {
         return;
     }
 
-    process *current = run_queues[priority].head;
-    process *prev = NULL;
-    // Find the process in the run queue
-    while (current != NULL && current != proc) {
-        prev = current;
-        current = current->next;
+    if (isQueued(proc)) {
+        return;
+    }
+    proc->readySince = currentTime();
+    noteAging(proc);
+
+    if (proc->period > 0) {
+        edfInsert(proc);
+    } else {
+        schedOps->enqueue(proc, 1);
+    }
+}
+
+/*
+helper function that checks if a process is in its run queue.
+Only the head of a queue has no prev link.
+*/
+int isQueued(process *proc) {
+    return proc->heapIndex >= 0 || proc->prev != NULL || run_queues[proc->level].head == proc ||
+           edfHead == proc;
+}
+
+/*
+helper function to remove a process from the run queue.
+A process that is not queued is left alone.
+*/
+void removeFromRunQueue(process *proc) {
+    //USLOSS_Console("[DEBUG] Removing process %d (%s) from priority queue %d\n", proc->pid, proc->cold->name, proc->priority);
+    int level = proc->level; 
+    if (level < 0 || level >= NUM_LEVELS) {
+        return;
     }
 
-    if (current == NULL) {
+    if (!isQueued(proc)) {
         return;
     }
 
-    // remove from q
-    if (prev == NULL) {
-        run_queues[priority].head = current->next;
-        if (run_queues[priority].head == NULL) {
-            run_queues[priority].tail = NULL;
-        }
+    if (proc->period > 0) {
+        edfRemove(proc);
     } else {
-        prev->next = current->next;
-        if (current->next == NULL) {
-            run_queues[priority].tail = prev;
-        }
+        schedOps->dequeue(proc);
     }
-    current->next = NULL;
 }
 
 /*
-This function switches the context to the new process
+This function switches the context to the new process. It starts with
+sliceUsed of its time slice already used up, 0 for a whole slice.
 */
-void context_switch(process *next_proc) {
+void context_switch(process *next_proc, int sliceUsed) {
 
     if (currentProcess == next_proc) {
         return; 
     }
 
-    // reset timer  
-    next_proc->timeUsed = 0;
+    // a detached process that quit is not running any more, free it
+    if (reapAfterSwitch != NULL && reapAfterSwitch != currentProcess) {
+        freeStack(reapAfterSwitch->stack, reapAfterSwitch->stackSize);
+        freeProcess(reapAfterSwitch);
+        reapAfterSwitch = NULL;
+    }
+
+    // start a new time slice
+    next_proc->timeUsed = sliceUsed;
+    next_proc->sliceStart = currentTime();
+    if (next_proc->sliceStart - next_proc->readySince > next_proc->maxWait) {
+        next_proc->maxWait = next_proc->sliceStart - next_proc->readySince;
+    }
+
+    // it is running, so it is done waiting and loses what it got from aging
+    if (next_proc->ageBoost > 0) {
+        next_proc->level += next_proc->ageBoost;
+        if (next_proc->level > next_proc->inheritLevel) {
+            next_proc->level = next_proc->inheritLevel;
+        }
+        next_proc->ageBoost = 0;
+    }
 
     // Update the current process pointer
     process *old_proc = currentProcess;
@@ -654,10 +2534,29 @@ void context_switch(process *next_proc) {
 
     // Load the next process's state
     if(old_proc == NULL){
-        USLOSS_ContextSwitch(NULL, &next_proc->context);
+        USLOSS_ContextSwitch(NULL, &next_proc->cold->context);
     }else{
-        //USLOSS_Console("[DEBUG] CONTEXT Switching from PID %d (%s) to PID %d (%s)\n", currentProcess->pid, currentProcess->name, next_proc->pid, next_proc->name);
-        USLOSS_ContextSwitch(&old_proc->context, &next_proc->context);
+        //USLOSS_Console("[DEBUG] CONTEXT Switching from PID %d (%s) to PID %d (%s)\n", currentProcess->pid, currentProcess->cold->name, next_proc->pid, next_proc->cold->name);
+        USLOSS_ContextSwitch(&old_proc->cold->context, &next_proc->cold->context);
+    }
+}
+
+/*
+charges the time since it was last charged to a process
+*/
+void chargeTime(process *proc) {
+    int now = currentTime();
+    int used = now - proc->sliceStart;
+
+    proc->timeUsed += used;
+    proc->cpuTime += used;
+    proc->sliceStart = now;
+    if (proc->period > 0) {
+        proc->budgetUsed += used;
+    }
+    if (inFairClass(proc)) {
+        proc->vruntime += (int64_t)used * fairWeight(3) / fairWeight(proc->priority);
+        fairAdvanceClock();
     }
 }
 
@@ -665,21 +2564,91 @@ void context_switch(process *next_proc) {
 blocks the current process
 */
 void blockMe() {
-    // Disable interrupts to avoid concurrency issues
+    waitOn(NULL, BLOCKED_ME);
+}
+
+/**
+Blocks the current process at the tail of a wait queue until wakeOne(),
+wakeAll() or unblockProc() wakes it. reason is shown by dumpProcesses().
+With a NULL queue the process is on no queue and only unblockProc() wakes it.
+*/
+void waitOn(waitQueue *queue, int reason) {
+    blockOn(queue, reason, 0);
+}
+
+/*
+waitOn(), but the process can go at the front of the queue. zap() puts
+zappers there, so the last one to zap a process is woken first.
+*/
+void blockOn(waitQueue *queue, int reason, int front) {
     int old_psr = disableInterrupts();
 
-    // Mark the current process as BLOCKED
-    currentProcess->state = BLOCKED;
+    process *proc = currentProcess;
+    if (queue != NULL) {
+        proc->waitingOn = queue;
+        if (front) {
+            proc->prevWaiter = NULL;
+            proc->nextWaiter = queue->head;
+            if (queue->head != NULL) {
+                queue->head->prevWaiter = proc;
+            } else {
+                queue->tail = proc;
+            }
+            queue->head = proc;
+        } else {
+            proc->prevWaiter = queue->tail;
+            proc->nextWaiter = NULL;
+            if (queue->tail != NULL) {
+                queue->tail->nextWaiter = proc;
+            } else {
+                queue->head = proc;
+            }
+            queue->tail = proc;
+        }
+    }
 
-    // Remove the process from its run queue
-    removeFromRunQueue(currentProcess);
+    proc->state = BLOCKED;
+    proc->blockReason = reason;
+    schedOps->block(proc);
 
-    // Call the dispatcher to switch to another process
     dispatcher();
 
-    // Restore interrupts
     restorePsr(old_psr);
 }
+
+/**
+Wakes the process that has waited longest on a wait queue. Returns its pid,
+or -1 if the queue is empty.
+*/
+int wakeOne(waitQueue *queue) {
+    int old_psr = disableInterrupts();
+
+    int pid = -1;
+    if (queue->head != NULL) {
+        pid = queue->head->pid;
+        wakeWaiters(queue, 0);
+        dispatcher();
+    }
+
+    restorePsr(old_psr);
+    return pid;
+}
+
+/**
+Wakes every process on a wait queue, with one scheduling decision for all
+of them like unblockProcs(). Returns how many it woke.
+*/
+int wakeAll(waitQueue *queue) {
+    int old_psr = disableInterrupts();
+
+    int woken = wakeWaiters(queue, 1);
+    if (woken > 0) {
+        dispatcher();
+    }
+
+    restorePsr(old_psr);
+    return woken;
+}
 /*
 unblocks a process at pid
 */
@@ -688,20 +2657,22 @@ int unblockProc(int pid) {
     int old_psr = disableInterrupts();
 
     // Find the process in the process table
-    int slot = pid % MAXPROC;
-    process *proc = &processTable[slot];
+    process *proc = findProcess(pid);
 
     // Check if the process exists and is blocked
-    if (proc->state != BLOCKED || proc->pid != pid) {
+    if (proc == NULL || proc->state != BLOCKED) {
         restorePsr(old_psr);
         return -2; // Process not blocked or doesn't exist
     }
 
-    // Mark the process as RUNNABLE
-    proc->state = READY;
+    // a real-time process waiting for its period is woken by rtRelease()
+    if (proc->blockReason == BLOCKED_PERIOD) {
+        restorePsr(old_psr);
+        return -1;
+    }
 
-    // Add the process back to its run queue
-    enqueue(proc);
+    // Mark the process as RUNNABLE and add it back to its run queue
+    wakeUp(proc);
 
     // Call the dispatcher to check if the newly unblocked process should run
     dispatcher();
@@ -712,6 +2683,77 @@ int unblockProc(int pid) {
     return 0;
 }
 
+/**
+Unblocks every blocked process in pids, and then makes one scheduling decision
+for all of them, so waking n processes costs one dispatch instead of n. The
+pids that are not blocked, or are real-time processes waiting for their
+period, are skipped. Returns how many processes it woke.
+*/
+int unblockProcs(int *pids, int count) {
+    int old_psr = disableInterrupts();
+
+    int woken = 0;
+    for (int i = 0; i < count; i++) {
+        process *proc = findProcess(pids[i]);
+        if (proc != NULL && proc->state == BLOCKED &&
+            proc->blockReason != BLOCKED_PERIOD) {
+            wakeUp(proc);
+            woken++;
+        }
+    }
+
+    if (woken > 0) {
+        dispatcher();
+    }
+
+    restorePsr(old_psr);
+    return woken;
+}
+
+/**
+Unblocks a process and, if its priority lets it run before the current
+process, hands it the cpu straight away with what is left of the current
+time slice. The current process goes to the front of its run queue. This is
+for a process that wakes another one and then waits for its answer.
+Returns -2 if the process is not blocked and -1 if it is waiting for its
+period, like unblockProc().
+*/
+int unblockAndSwitch(int pid) {
+    int old_psr = disableInterrupts();
+
+    process *proc = findProcess(pid);
+    if (proc == NULL || proc->state != BLOCKED) {
+        restorePsr(old_psr);
+        return -2;
+    }
+    if (proc->blockReason == BLOCKED_PERIOD) {
+        restorePsr(old_psr);
+        return -1;
+    }
+
+    chargeTime(currentProcess);
+    wakeUp(proc);
+
+    // only hand off when the dispatcher would pick it anyway and it is not
+    // below the current process, idle is never queued so it never hands off
+    if (currentProcess == &idleProcess ||
+        edfHead != NULL || proc->period > 0 || currentProcess->period > 0 ||
+        schedOps->pickNext() != proc || proc->level > currentProcess->level) {
+        dispatcher();
+        restorePsr(old_psr);
+        return 0;
+    }
+
+    dispatchHandoffs++;
+    removeFromRunQueue(proc);
+    currentProcess->state = READY;
+    enqueueFront(currentProcess);
+    context_switch(proc, currentProcess->timeUsed);
+
+    restorePsr(old_psr);
+    return 0;
+}
+
 /*
 zaps a pid and blocks the current process
 */
@@ -735,11 +2777,10 @@ void zap(int pid) {
     }
 
     // Find the target process in the process table
-    int slot = pid % MAXPROC;
-    process *target = &processTable[slot];
+    process *target = findProcess(pid);
 
     // Check if the target process exists
-    if (target->state == EMPTY || target->pid != pid) {
+    if (target == NULL || target->state == EMPTY) {
         USLOSS_Console("ERROR: Attempt to zap() a non-existent process.\n", pid);
         USLOSS_Halt(1);
     }
@@ -749,15 +2790,408 @@ void zap(int pid) {
         USLOSS_Halt(1);
         }
     
-    // Add the current process to the zap list of the target
-    currentProcess->nextZap = target->zapList;
-    target->zapList = currentProcess;
+    // Block the zapper until the target quits, the target runs at least at
+    // its level until then
+    currentProcess->zapTarget = target;
+    inheritPriority(currentProcess, target);
+    blockOn(&target->zappers, BLOCKED_ZAP, 1);
+    currentProcess->zapTarget = NULL;
+}
+/**
+Starts a new process group led by the current process. The processes it
+sporks from now on start in the group, and so do theirs. Returns the group
+id, which is the pid of the leader.
+*/
+int newGroup(void) {
+    currentProcess->gid = currentProcess->pid;
+    return currentProcess->gid;
+}
 
-    // Block the zapper
-    currentProcess->state = BLOCKED;
+/**
+Returns the process group of the current process, 0 if it is in none.
+*/
+int getGroup(void) {
+    return currentProcess->gid;
+}
 
-    dispatcher();
+/*
+Returns the process after proc when walking the tree under root, children
+before siblings, or NULL when the walk is over. The walk follows the child
+lists, so it costs one step per process of the tree.
+*/
+process *nextInTree(process *proc, process *root) {
+    if (proc->first_child != NULL) {
+        return proc->first_child;
+    }
+    while (proc != root) {
+        if (proc->next_sibling != NULL) {
+            return proc->next_sibling;
+        }
+        proc = proc->parent;
+    }
+    return NULL;
+}
+
+/*
+Marks one member for zapMembers(): it is counted in marked if it is now
+waiting to be zapped by the current process, in mine if it already was, and
+remembered in other if another zapGroup() or zapTree() has it
+*/
+void zapMark(process *p, int *marked, int *mine, process **other) {
+    if (p == currentProcess || p->pid == 1 ||
+        p->state == FINISHED || p->state == QUIT) {
+        return;
+    }
+    if (p->groupZapper == NULL) {
+        p->groupZapper = currentProcess;
+        inheritPriority(currentProcess, p);
+        (*marked)++;
+    } else if (p->groupZapper == currentProcess) {
+        (*mine)++;
+    } else {
+        *other = p;
+    }
+}
+
+/*
+Zaps every live process of group gid, or of the tree under root, and blocks
+once until all of them have quit: each member counts down zapPending in
+quit() and the last one wakes the caller. A member that another zapGroup()
+or zapTree() is already waiting for is zapped with zap() afterwards.
+Members sporked while the caller waited are caught by the next pass.
+Returns how many processes were zapped, or -1 if group gid has no processes.
+*/
+int zapMembers(int gid, process *root) {
+    int old_psr = disableInterrupts();
+
+    int zapped = 0;
+    for (int pass = 0; ; pass++) {
+        int marked = 0;
+        int mine = 0;
+        int seen = 0;
+        process *other = NULL;
+
+        if (root != NULL) {
+            for (process *p = root; p != NULL; p = nextInTree(p, root)) {
+                zapMark(p, &marked, &mine, &other);
+            }
+        } else {
+            int words = (pidMapSize + 63) / 64;
+            for (int w = 0; w < words; w++) {
+                uint64_t used = ~freeMapSlots[w];
+                if (w == words - 1 && pidMapSize % 64 != 0) {
+                    used &= (1ULL << (pidMapSize % 64)) - 1;
+                }
+                while (used != 0) {
+                    process *p = pidMap[w * 64 + __builtin_ctzll(used)];
+                    used &= used - 1;
+                    if (p->gid == gid) {
+                        seen++;
+                        zapMark(p, &marked, &mine, &other);
+                    }
+                }
+            }
+            if (pass == 0 && seen == 0) {
+                restorePsr(old_psr);
+                return -1;
+            }
+        }
+
+        if (marked > 0 || mine > 0) {
+            zapped += marked;
+            currentProcess->zapPending += marked;
+            blockOn(NULL, BLOCKED_ZAP, 0);
+        } else if (other != NULL) {
+            zapped++;
+            zap(other->pid);
+        } else {
+            break;
+        }
+    }
+
+    restorePsr(old_psr);
+    return zapped;
+}
+
+/**
+Zaps every process of group gid but the current one, and blocks until all
+of them have quit. Returns how many it zapped, or -1 if gid is not a group,
+that is no process, not even one that has quit and not been joined, is in it.
+*/
+int zapGroup(int gid) {
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call zapGroup while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+    if (gid <= 0) {
+        return -1;
+    }
+    return zapMembers(gid, NULL);
+}
+
+/**
+Zaps the process pid and all of its descendants, and blocks until all of
+them have quit. The current process is left out if it is in the tree.
+Returns how many it zapped, or -1 if there is no such process.
+*/
+int zapTree(int pid) {
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call zapTree while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+    if (pid == 1) {
+        USLOSS_Console("ERROR: Attempt to zap() init.\n");
+        USLOSS_Halt(1);
+    }
+
+    process *root = findProcess(pid);
+    if (root == NULL) {
+        return -1;
+    }
+    return zapMembers(0, root);
+}
+
+/**
+Creates a pool of workers children of the current process at priority, each
+with a stack of stacksize bytes. They wait for jobs from poolSubmit(), so a
+short job does not pay for a spork() and a join(). Returns the pool id, -1 if
+the arguments are bad or there are already MAXPOOLS pools, or -2 if a worker
+could not be sporked.
+*/
+int poolCreate(int workers, int priority, int stacksize) {
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call poolCreate while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+    if (workers < 1 || priority < 1 || priority > LOWEST_PRIORITY) {
+        return -1;
+    }
+
+    int id = 0;
+    while (id < MAXPOOLS && pools[id].owner != NULL) {
+        id++;
+    }
+    if (id == MAXPOOLS) {
+        return -1;
+    }
+
+    WorkerPool *pool = &pools[id];
+    pool->workerPids = malloc(workers * sizeof(int));
+    if (pool->workerPids == NULL) {
+        return -1;
+    }
+    pool->owner = currentProcess;
+    pool->size = 0;
+    pool->stopping = 0;
+    pool->nextJobId = 1;
+    pool->outstanding = 0;
+    pool->freeJobs = NULL;
+    for (int i = MAXJOBS - 1; i >= 0; i--) {
+        pool->jobs[i].next = pool->freeJobs;
+        pool->freeJobs = &pool->jobs[i];
+    }
+    pool->pendingHead = pool->pendingTail = NULL;
+    pool->doneHead = pool->doneTail = NULL;
+    pool->idle.head = pool->idle.tail = NULL;
+    pool->collectors.head = pool->collectors.tail = NULL;
+
+    for (int i = 0; i < workers; i++) {
+        char name[MAXNAME];
+        snprintf(name, sizeof(name), "pool%d-worker%d", id, i);
+        int pid = spork(name, poolWorker, pool, stacksize, priority);
+        if (pid < 0) {
+            poolDestroy(id);
+            return -2;
+        }
+        pool->workerPids[pool->size++] = pid;
+    }
+    return id;
+}
+
+/*
+The main function of a pool worker: runs pending jobs in the order they were
+submitted, and waits on the idle queue when there are none
+*/
+int poolWorker(void *arg) {
+    WorkerPool *pool = arg;
+
+    int psr = disableInterrupts();
+    for (;;) {
+        Job *job = pool->pendingHead;
+        if (job != NULL) {
+            pool->pendingHead = job->next;
+            if (pool->pendingHead == NULL) {
+                pool->pendingTail = NULL;
+            }
+
+            restorePsr(psr);
+            int result = job->func(job->arg);
+            psr = disableInterrupts();
+
+            job->result = result;
+            job->next = NULL;
+            if (pool->doneTail != NULL) {
+                pool->doneTail->next = job;
+            } else {
+                pool->doneHead = job;
+            }
+            pool->doneTail = job;
+            wakeOne(&pool->collectors);
+        } else if (pool->stopping) {
+            break;
+        } else {
+            blockOn(&pool->idle, BLOCKED_JOB, 0);
+        }
+    }
+    restorePsr(psr);
+    return 0;
+}
+
+/*
+Finds a pool that is in use, NULL if there is none with the id
+*/
+WorkerPool *findPool(int pool) {
+    if (pool < 0 || pool >= MAXPOOLS || pools[pool].owner == NULL) {
+        return NULL;
+    }
+    return &pools[pool];
+}
+
+/**
+Gives a job to a pool, an idle worker is woken up to run func(arg). Returns
+the id of the job, -1 if there is no such pool, or -2 if the pool already
+has MAXJOBS jobs that are not collected.
+*/
+int poolSubmit(int pool, int (*func)(void *), void *arg) {
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call poolSubmit while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+
+    int psr = disableInterrupts();
+
+    WorkerPool *p = findPool(pool);
+    if (p == NULL || p->stopping || func == NULL) {
+        restorePsr(psr);
+        return -1;
+    }
+    Job *job = p->freeJobs;
+    if (job == NULL) {
+        restorePsr(psr);
+        return -2;
+    }
+    p->freeJobs = job->next;
+
+    job->id = p->nextJobId++;
+    job->func = func;
+    job->arg = arg;
+    job->next = NULL;
+    if (p->pendingTail != NULL) {
+        p->pendingTail->next = job;
+    } else {
+        p->pendingHead = job;
+    }
+    p->pendingTail = job;
+    p->outstanding++;
+
+    int id = job->id;
+    wakeOne(&p->idle);
+
+    restorePsr(psr);
+    return id;
+}
+
+/**
+Collects the result of a finished job of a pool, in the order the jobs
+finished, blocking until one finishes. Returns the id of the job, -1 if
+there is no such pool or it is destroyed while the caller waits, or -2 if the
+pool has no jobs left to collect.
+*/
+int poolCollect(int pool, int *result) {
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call poolCollect while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+
+    int psr = disableInterrupts();
+
+    WorkerPool *p = findPool(pool);
+    if (p == NULL) {
+        restorePsr(psr);
+        return -1;
+    }
+    if (p->outstanding == 0) {
+        restorePsr(psr);
+        return -2;
+    }
+    int generation = p->generation;
+    while (p->doneHead == NULL) {
+        waitOn(&p->collectors, BLOCKED_JOB);
+        // the slot may even have been given to a new pool by now
+        if (p->generation != generation) {
+            restorePsr(psr);
+            return -1;
+        }
+    }
+
+    Job *job = p->doneHead;
+    p->doneHead = job->next;
+    if (p->doneHead == NULL) {
+        p->doneTail = NULL;
+    }
+    p->outstanding--;
+
+    *result = job->result;
+    int id = job->id;
+    job->next = p->freeJobs;
+    p->freeJobs = job;
+
+    restorePsr(psr);
+    return id;
+}
+
+/**
+Shuts a pool down: the workers finish the jobs that are pending and quit,
+and the current process, which must have created the pool, joins them.
+Results that were not collected are lost, and the processes still waiting
+in poolCollect() get -1. Returns -1 if there is no such pool or it is not
+the current process's.
+*/
+int poolDestroy(int pool) {
+    if (isKernel() != 1) {
+        USLOSS_Console("ERROR: Someone attempted to call poolDestroy while in user mode!\n");
+        USLOSS_Halt(1);
+    }
+
+    int psr = disableInterrupts();
+
+    WorkerPool *p = findPool(pool);
+    if (p == NULL || p->owner != currentProcess || p->stopping) {
+        restorePsr(psr);
+        return -1;
+    }
+
+    p->stopping = 1;
+    wakeAll(&p->idle);
+    for (int i = 0; i < p->size; i++) {
+        int status;
+        joinPid(p->workerPids[i], &status);
+    }
+
+    // the slot is given up before the collectors run again, and they see
+    // from the generation that their pool is gone
+    free(p->workerPids);
+    p->workerPids = NULL;
+    p->owner = NULL;
+    p->generation++;
+    if (wakeWaiters(&p->collectors, 1) > 0) {
+        dispatcher();
+    }
+
+    restorePsr(psr);
+    return 0;
 }
+
 /*Helper function to dump all the runqeuesu
 */
 void dumpRunQueue() {
@@ -765,16 +3199,19 @@ void dumpRunQueue() {
     USLOSS_Console(" DUMPING RUN QUEUES\n");
     USLOSS_Console("=========================\n");
 
-    for (int priority = 0; priority < 6; priority++) {
-        USLOSS_Console("[Priority %d] -> ", priority + 1);
-        process *current = run_queues[priority].head;
-        
-        if (current == NULL) {
-            USLOSS_Console("(empty)");
-        }
+    // only the non-empty levels are printed
+    uint64_t pending = readyBitmap;
+    if (pending == 0) {
+        USLOSS_Console("(empty)\n");
+    }
+    while (pending != 0) {
+        int level = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        USLOSS_Console("[Level %d] -> ", level);
+        process *current = run_queues[level].head;
 
         while (current != NULL) {
-            USLOSS_Console("PID %d (%s) -> ", current->pid, current->name);
+            USLOSS_Console("PID %d (%s) -> ", current->pid, current->cold->name);
             current = current->next;
         }
         USLOSS_Console("NULL\n");
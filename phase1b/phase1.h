@@ -8,7 +8,8 @@
 #include <usloss.h>
 
 /*
- * Maximum number of processes. 
+ * Number of processes the process table starts with.  The table grows
+ * when it is full, so this is not a limit.
  */
 
 #define MAXPROC      50
@@ -19,6 +20,73 @@
 
 #define MAXNAME      50
 
+/*
+ * Maximum number of worker pools, and of jobs a pool holds that have not
+ * been collected.
+ */
+
+#define MAXPOOLS     8
+#define MAXJOBS      64
+
+/*
+ * Flags for setDumpStats(), the statistics that dumpProcesses() prints
+ * after the process table.
+ */
+
+#define DUMP_STACK_POOL  0x1     /* stack pool hits and misses */
+#define DUMP_PROC_STATS  0x2     /* cpu time, longest wait, stack use and deadline misses */
+#define DUMP_DISPATCH    0x4     /* dispatcher calls, fast paths and handoffs */
+
+/*
+ * The statistics kept for one process, filled in by getProcStats().  Times
+ * are in microseconds.  DUMP_PROC_STATS prints the same numbers.
+ */
+
+typedef struct procStats {
+    int cpuTime;             /* cpu time used */
+    int maxWait;             /* longest time it waited in a ready queue */
+    int stackUsed;           /* bytes of its stack it has touched, to the page */
+    int stackSize;
+    int deadlineMisses;      /* periods a real-time process did not finish in */
+} procStats;
+
+/*
+ * Scheduling policies for setSchedPolicy().  SCHED_FIXED runs processes
+ * strictly by the priority they were sporked with.  SCHED_MLFQ moves
+ * processes that use up their time slice below the ones that block.
+ * SCHED_FAIR shares the cpu between processes in proportion to a weight
+ * that doubles with each step up in priority.
+ */
+
+#define SCHED_FIXED      0
+#define SCHED_MLFQ       1
+#define SCHED_FAIR       2
+
+/*
+ * Why a process is blocked, dumpProcesses() prints it in the process table.
+ * blockMe() uses BLOCKED_ME; the later phases pick their own codes above 10
+ * for the wait queues in their mailboxes, semaphores and devices.
+ */
+
+#define BLOCKED_JOIN     1       /* join() or joinPid() */
+#define BLOCKED_ZAP      2       /* zap() */
+#define BLOCKED_ME       3       /* blockMe() */
+#define BLOCKED_PERIOD   4       /* a real-time process waiting for its next period */
+#define BLOCKED_JOB      5       /* a pool worker or poolCollect() */
+
+/*
+ * A queue of processes blocked waiting for the same thing, oldest first.
+ * The links live in the process table, so waiting and waking take no memory
+ * and constant time.  A queue must be zeroed before it is first used.
+ */
+
+struct process;
+
+typedef struct waitQueue {
+    struct process *head;
+    struct process *tail;
+} waitQueue;
+
 /*
  * Maximum number of syscalls.
  */
@@ -31,20 +99,50 @@
  */
 
 extern void phase1_init(void);
+extern void phase1_options(int argc, char **argv);
 extern int  spork(char *name, int(*func)(void *), void *arg,
                   int stacksize, int priority);
+extern int  sporkDetached(char *name, int(*func)(void *), void *arg,
+                          int stacksize, int priority);
+extern int  sporkRealtime(char *name, int(*func)(void *), void *arg,
+                          int stacksize, int period, int budget);
+extern int  waitPeriod(void);
 extern int  join(int *status);
+extern int  joinPid(int pid, int *status);
+extern int  tryJoin(int *status);
 extern void quit(int status) __attribute__((__noreturn__));
 extern void zap(int pid);
+extern int  zapGroup(int gid);
+extern int  zapTree(int pid);
+extern int  newGroup(void);
+extern int  getGroup(void);
 extern void blockMe(void);
 extern int  unblockProc(int pid);
+extern int  unblockAndSwitch(int pid);
+extern int  unblockProcs(int *pids, int count);
+extern void waitOn(waitQueue *queue, int reason);
+extern int  wakeOne(waitQueue *queue);
+extern int  wakeAll(waitQueue *queue);
+
+extern int  poolCreate(int workers, int priority, int stacksize);
+extern int  poolSubmit(int pool, int (*func)(void *), void *arg);
+extern int  poolCollect(int pool, int *result);
+extern int  poolDestroy(int pool);
 
 extern void dispatcher(void);
 
 extern int  currentTime(void);
+extern int  readtime(void);
 
 extern int  getpid(void);
 extern void dumpProcesses(void);
+extern void setDumpStats(int flags);
+extern int  getProcStats(int pid, procStats *stats);
+extern void setSchedPolicy(int policy);
+extern int  setSchedPolicyByName(char *name);
+extern void setPriorityInheritance(int enabled);
+extern int  setPriority(int pid, int priority);
+extern void setAging(int period);
 
 
 /*
@@ -69,6 +167,13 @@ extern void phase3_start_service_processes(void);
 extern void phase4_start_service_processes(void);
 extern void phase5_start_service_processes(void);
 
+/* this function is called by the idle process, when no process is ready,
+ * to find out if any process is waiting for a device.  If none is, every
+ * process is blocked for good.  Phase 2 implements it; before that, the
+ * testcase provides one that returns 0.
+ */
+extern int phase2_check_io(void);
+
 /* this function is called by the init process, after the service
  * processes are running, to start whatever processes the testcase
  * wants to run.  This may call spork() many times, and
@@ -0,0 +1,135 @@
+/*
+ * Dispatcher micro-benchmark, not one of the testcases: its output is
+ * timing, so it has no .out file.  Build and run it with "make bench".
+ *
+ * Ring: a token goes around a ring of processes with blockMe() and
+ * unblockProc(), so every hop is one dispatch and one context switch to a
+ * different PCB.
+ *
+ * Requeue: setSchedPolicy(SCHED_FIXED) is called over and over with a number
+ * of ready processes.  It walks the pid map, and takes every ready process
+ * out of its run queue and puts it back, touching the scheduling fields of
+ * every PCB and nothing else.
+ *
+ * Both are timed with a growing number of processes, the best of TRIES
+ * runs is printed.  A few PCBs stay in the cache, many have to be fetched,
+ * so the cost per process grows with their number by how many cache lines
+ * the scheduler touches in each of them.  The times are host wall clock
+ * time, currentTime() is the simulated clock.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define HOPS     20000
+#define REQUEUES 200000
+#define MAXRING  2000
+#define MAXREADY 20000
+#define TRIES    3
+
+int Hop(void *);
+int Ready(void *);
+
+int ringSize;
+int rounds;
+int ring[MAXRING];
+
+/* microseconds of host time */
+long long wallTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int testcase_main()
+{
+    int sizes[] = { 4, 32, 256, MAXRING };
+    int readySizes[] = { 4, 256, 2000, MAXREADY };
+    int s, i, n, t, status, reps;
+    long long start, elapsed, best;
+
+    USLOSS_Console("RING   PROCS      HOPS   TIME(us)  NS/HOP\n");
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        ringSize = sizes[s];
+        rounds = HOPS / ringSize;
+        if (rounds == 0)
+            rounds = 1;
+
+        best = -1;
+        for (t = 0; t < TRIES; t++)
+        {
+            // the hops run at a higher priority and block straight away
+            for (i = 0; i < ringSize; i++)
+                ring[i] = spork("Hop", Hop, (void *)(long)i, USLOSS_MIN_STACK, 2);
+
+            start = wallTime();
+            unblockProc(ring[0]);
+            elapsed = wallTime() - start;
+            if (best < 0 || elapsed < best)
+                best = elapsed;
+
+            for (i = 0; i < ringSize; i++)
+                join(&status);
+        }
+
+        n = rounds * ringSize;
+        USLOSS_Console("     %7d %9d %10lld %7d\n", ringSize, n, best,
+                       (int)(best * 1000 / n));
+    }
+
+    USLOSS_Console("REQUEUE PROCS     MOVES   TIME(us) NS/MOVE\n");
+    for (s = 0; s < sizeof(readySizes) / sizeof(readySizes[0]); s++)
+    {
+        // lower priority, so they stay in the run queues until the join()s
+        for (i = 0; i < readySizes[s]; i++)
+            spork("Ready", Ready, NULL, USLOSS_MIN_STACK, 4);
+
+        reps = REQUEUES / readySizes[s];
+        best = -1;
+        for (t = 0; t < TRIES; t++)
+        {
+            start = wallTime();
+            for (i = 0; i < reps; i++)
+            {
+                setSchedPolicy(SCHED_FIXED);
+                setSchedPolicy(SCHED_FIXED);
+            }
+            elapsed = wallTime() - start;
+            if (best < 0 || elapsed < best)
+                best = elapsed;
+        }
+
+        for (i = 0; i < readySizes[s]; i++)
+            join(&status);
+
+        n = 2 * reps * readySizes[s];
+        USLOSS_Console("        %7d %9d %10lld %7d\n", readySizes[s], n, best,
+                       (int)(best * 1000 / n));
+    }
+
+    return 0;
+}
+
+int Hop(void *arg)
+{
+    int i = (int)(long)arg;
+    int next = (i + 1) % ringSize;
+    int r;
+
+    for (r = 0; r < rounds; r++)
+    {
+        blockMe();
+        unblockProc(ring[next]);
+    }
+    return 0;
+}
+
+int Ready(void *arg)
+{
+    return 0;
+}
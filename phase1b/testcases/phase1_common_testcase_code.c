@@ -16,6 +16,7 @@ void startup(int argc, char **argv)
 {
     USLOSS_IntVec[USLOSS_CLOCK_INT] = trivial_clock_handler;
 
+    phase1_options(argc, argv);
     phase1_init();
     dispatcher();
 }
@@ -54,6 +55,11 @@ void phase5_start_service_processes()
     USLOSS_Console("%s() called -- currently a NOP\n", __func__);
 }
 
+int phase2_check_io()
+{
+    return 0;
+}
+
 
 
 int currentTime()
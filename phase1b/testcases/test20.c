@@ -1,9 +1,9 @@
 /*
- * Check if -1 is returned when there are no more process slots.
+ * Check that the process table grows past MAXPROC slots.
  * Attempt to start MAXPROC + 2 processes; i.e., 52 processes
- * Process table has 50 slots. testcase_main and sentinel occupy two of
- *    the slots.  Thus, 48 new processes will start, with error
- *    messages about the last 4 attempts.
+ * The table starts with 50 slots and init and testcase_main occupy two
+ *    of them.  The table grows when the 49th child is created, so all
+ *    52 children start and there are no error messages.
  */
 
 #include <stdio.h>
@@ -17,7 +17,7 @@ int testcase_main()
     int i, pid1;
 
     USLOSS_Console("testcase_main(): started\n");
-    USLOSS_Console("EXPECTATION: Attempt to create MAXPROC+2 processes (without calling join() on any of them).  This will work many times but eventually fail because all of the procTable slots are full.  We will only print out info about the failed ones.\n");
+    USLOSS_Console("EXPECTATION: Attempt to create MAXPROC+2 processes (without calling join() on any of them).  The process table grows when it is full, so all of them will work.  We will only print out info about failed ones, if any.\n");
 
     USLOSS_Console("testcase_main(): start %d processes\n", MAXPROC+2);
 
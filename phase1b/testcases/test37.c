@@ -0,0 +1,65 @@
+/*
+ * Checks time slicing and cpu time accounting.
+ *
+ * testcase_main creates two children at the same priority, which is lower
+ * than its own, and then joins.  Each child spins until readtime() says
+ * that it has used its share of cpu, 200ms for the first and 400ms for
+ * the second.  Since the time slice is 80ms, the children must take turns
+ * on the cpu while they spin, and the first one always finishes first.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(void *);
+
+struct spinner {
+    char *name;
+    int   cpuTime;
+} spinA = { "A", 200000 }, spinB = { "B", 400000 };
+
+int lastRunner = 0;
+
+int testcase_main()
+{
+    int status, pid1, pid2, kidpid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The two children will share the cpu, both will see the other run before they finish.\n");
+
+    pid1 = spork("XXp1", XXp1, &spinA, USLOSS_MIN_STACK, 4);
+    pid2 = spork("XXp1", XXp1, &spinB, USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of children %d and %d\n", pid1, pid2);
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    struct spinner *me = arg;
+    int switches = 0;
+
+    USLOSS_Console("XXp1(): %s started\n", me->name);
+
+    while (readtime() < me->cpuTime)
+    {
+        if (lastRunner != getpid())
+        {
+            lastRunner = getpid();
+            switches++;
+        }
+    }
+
+    if (switches > 1)
+        USLOSS_Console("XXp1(): %s shared the cpu with the other child\n", me->name);
+    else
+        USLOSS_Console("ERROR: XXp1(): %s was never interrupted by the other child\n", me->name);
+
+    quit(getpid());
+}
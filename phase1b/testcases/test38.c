@@ -0,0 +1,53 @@
+/*
+ * Check that the process table scales far past MAXPROC.
+ *
+ * testcase_main creates 10000 children at a lower priority than its own,
+ * so none of them runs until testcase_main blocks in join().  All of them
+ * are alive at the same time.  Then testcase_main joins with all of them,
+ * and checks that every status matches the pid of the child.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define NUM_KIDS 10000
+
+int XXp1(void *);
+
+int testcase_main()
+{
+    int i, pid, status, failed = 0;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: All %d children are created and joined.\n", NUM_KIDS);
+
+    for (i = 0; i < NUM_KIDS; i++)
+    {
+        pid = spork("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 4);
+        if (pid < 0)
+        {
+            USLOSS_Console("ERROR: testcase_main(): spork() failed: i=%d, pid is %d.\n", i, pid);
+            USLOSS_Halt(1);
+        }
+    }
+    USLOSS_Console("testcase_main(): created %d children\n", NUM_KIDS);
+
+    for (i = 0; i < NUM_KIDS; i++)
+    {
+        pid = join(&status);
+        if (pid < 0 || status != pid)
+            failed++;
+    }
+    USLOSS_Console("testcase_main(): joined %d children, %d failed\n", NUM_KIDS, failed);
+
+    if (join(&status) != -2)
+        USLOSS_Console("ERROR: testcase_main(): join() did not return -2 after the last child\n");
+
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    quit(getpid());
+}
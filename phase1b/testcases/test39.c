@@ -0,0 +1,57 @@
+/*
+ * Tests joinPid() and tryJoin().
+ *
+ * testcase_main creates three children at a lower priority than its own,
+ * so none of them runs until testcase_main blocks.  It then waits for
+ * the second child with joinPid(); the first child runs and terminates
+ * on the way, but that does not wake testcase_main up.  The first child
+ * is then collected with tryJoin(), which never blocks.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(void *);
+
+int testcase_main()
+{
+    int status, pid1, pid2, pid3, kidpid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: joinPid() waits for one specific child, tryJoin() only collects children that have already terminated.\n");
+
+    pid1 = spork("XXp1", XXp1, "XXp1_a", USLOSS_MIN_STACK, 4);
+    pid2 = spork("XXp1", XXp1, "XXp1_b", USLOSS_MIN_STACK, 4);
+    pid3 = spork("XXp1", XXp1, "XXp1_c", USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of children %d, %d and %d\n", pid1, pid2, pid3);
+
+    kidpid = tryJoin(&status);
+    USLOSS_Console("testcase_main(): tryJoin() before any child ran returned %d -- expected 0\n", kidpid);
+
+    kidpid = joinPid(pid2, &status);
+    USLOSS_Console("testcase_main(): joinPid(%d) returned %d, status = %d\n", pid2, kidpid, status);
+
+    kidpid = tryJoin(&status);
+    USLOSS_Console("testcase_main(): tryJoin() returned %d, status = %d -- expected the first child\n", kidpid, status);
+
+    kidpid = tryJoin(&status);
+    USLOSS_Console("testcase_main(): tryJoin() returned %d -- expected 0, the third child has not run\n", kidpid);
+
+    kidpid = joinPid(pid1, &status);
+    USLOSS_Console("testcase_main(): joinPid(%d) of a child that was already joined returned %d -- expected -2\n", pid1, kidpid);
+
+    kidpid = joinPid(pid3, &status);
+    USLOSS_Console("testcase_main(): joinPid(%d) returned %d, status = %d\n", pid3, kidpid, status);
+
+    kidpid = tryJoin(&status);
+    USLOSS_Console("testcase_main(): tryJoin() with no children returned %d -- expected -2\n", kidpid);
+
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    USLOSS_Console("XXp1(): %s started, pid = %d\n", arg, getpid());
+    quit(getpid() * 10);
+}
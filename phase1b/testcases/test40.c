@@ -0,0 +1,42 @@
+/*
+ * Tests the stack pool.
+ *
+ * phase1_init() puts a few of the smallest stacks in the pool, and init
+ * and testcase_main take two of them.  testcase_main then creates and
+ * joins children one at a time: every child with a small stack gets the
+ * stack of the child before it back from the pool.  The first child with
+ * a bigger stack misses, the second one reuses that stack.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(void *);
+
+int testcase_main()
+{
+    int i, status;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: 5 small stack children all hit in the pool, of the 2 big stack children only the first misses.\n");
+
+    setDumpStats(DUMP_STACK_POOL);
+
+    for (i = 0; i < 5; i++) {
+        spork("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 2);
+        join(&status);
+    }
+    for (i = 0; i < 2; i++) {
+        spork("XXp1", XXp1, NULL, 2 * USLOSS_MIN_STACK, 2);
+        join(&status);
+    }
+
+    dumpProcesses();
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    quit(0);
+}
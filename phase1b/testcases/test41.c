@@ -0,0 +1,62 @@
+/*
+ * Checks the MLFQ scheduling policy.
+ *
+ * testcase_main switches to SCHED_MLFQ and creates a cpu bound child at
+ * priority 2, which is above its own priority, and a child at priority 3
+ * which only prints a line.  With fixed priorities the second child could
+ * not run until the first one was done; with MLFQ the first child drops
+ * below it after using up its time slice, so the second child gets to run
+ * while the first one is still spinning.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Hog(void *);
+int Light(void *);
+
+int lightDone = 0;
+
+int testcase_main()
+{
+    int status, pid1, pid2, kidpid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Light will run before Hog finishes, even though Hog has the higher priority.\n");
+
+    setSchedPolicy(SCHED_MLFQ);
+
+    pid1 = spork("Hog", Hog, NULL, USLOSS_MIN_STACK, 2);
+    pid2 = spork("Light", Light, NULL, USLOSS_MIN_STACK, 3);
+    USLOSS_Console("testcase_main(): after fork of children %d and %d\n", pid1, pid2);
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    return 0;
+}
+
+int Hog(void *arg)
+{
+    USLOSS_Console("Hog(): started\n");
+
+    while (readtime() < 400000)
+        ;
+
+    if (lightDone)
+        USLOSS_Console("Hog(): Light ran while I was spinning\n");
+    else
+        USLOSS_Console("ERROR: Hog(): Light did not run until I was done\n");
+
+    quit(1);
+}
+
+int Light(void *arg)
+{
+    USLOSS_Console("Light(): running\n");
+    lightDone = 1;
+    quit(2);
+}
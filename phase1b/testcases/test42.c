@@ -0,0 +1,55 @@
+/*
+ * Checks the fair share scheduling policy.
+ *
+ * testcase_main switches to SCHED_FAIR and creates one spinner at priority
+ * 3 and one at priority 4.  Both spin until the same point in time, and
+ * with fixed priorities the second one would not get any cpu.  With fair
+ * sharing the weight of priority 3 is twice the weight of priority 4, so the
+ * first one should get about twice as much cpu as the second.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(void *);
+
+int stopTime;
+int cpuUsed[2];
+
+int testcase_main()
+{
+    int status, pid1, pid2, kidpid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The priority 3 child gets about twice the cpu of the priority 4 child.\n");
+
+    setSchedPolicy(SCHED_FAIR);
+
+    stopTime = currentTime() + 900000;
+    pid1 = spork("XXp1", XXp1, &cpuUsed[0], USLOSS_MIN_STACK, 3);
+    pid2 = spork("XXp1", XXp1, &cpuUsed[1], USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of children %d and %d\n", pid1, pid2);
+
+    kidpid = joinPid(pid1, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    kidpid = joinPid(pid2, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    if (cpuUsed[0] > cpuUsed[1] * 3 / 2 && cpuUsed[0] < cpuUsed[1] * 5 / 2)
+        USLOSS_Console("testcase_main(): the cpu was shared 2 to 1\n");
+    else
+        USLOSS_Console("ERROR: testcase_main(): the cpu was shared %d to %d\n", cpuUsed[0], cpuUsed[1]);
+
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    int *used = arg;
+
+    while (currentTime() < stopTime)
+        *used = readtime();
+
+    quit(getpid());
+}
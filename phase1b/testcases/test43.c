@@ -0,0 +1,92 @@
+/*
+ * Checks real-time processes.
+ *
+ * testcase_main creates a periodic process that uses 30ms of cpu every
+ * 100ms, and one that spins until the first is done but only has a budget
+ * of 20ms per 100ms.  A third real-time process would push the promised cpu over the
+ * limit, so sporkRealtime() must turn it down.  A low priority spinner
+ * keeps the cpu busy while the real-time processes wait for their periods.
+ * The spinners do not poll the clock, since that can make USLOSS drop
+ * clock interrupts.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Periodic(void *);
+int Overrun(void *);
+int Spinner(void *);
+
+int stopOverrun = 0;
+int stopSpinner = 0;
+
+int testcase_main()
+{
+    int status, pid1, pid2, pid3, pid4, kidpid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Periodic runs once per period, Overrun is held to its budget and the third real-time process is turned down.\n");
+
+    pid1 = spork("Spinner", Spinner, NULL, USLOSS_MIN_STACK, 5);
+    pid2 = sporkRealtime("Periodic", Periodic, NULL, USLOSS_MIN_STACK, 100000, 30000);
+    pid3 = sporkRealtime("Overrun", Overrun, NULL, USLOSS_MIN_STACK, 100000, 20000);
+    USLOSS_Console("testcase_main(): after fork of children %d, %d and %d\n", pid1, pid2, pid3);
+
+    pid4 = sporkRealtime("TooMuch", Periodic, NULL, USLOSS_MIN_STACK, 100000, 70000);
+    USLOSS_Console("testcase_main(): sporkRealtime() of a process that does not fit returned %d\n", pid4);
+
+    kidpid = joinPid(pid2, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    stopOverrun = 1;
+    kidpid = joinPid(pid3, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    stopSpinner = 1;
+    kidpid = joinPid(pid1, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    return 0;
+}
+
+int Periodic(void *arg)
+{
+    int start = currentTime();
+
+    for (int i = 0; i < 5; i++)
+    {
+        int until = readtime() + 10000;
+        while (readtime() < until)
+            ;
+        waitPeriod();
+    }
+
+    if (currentTime() - start >= 400000)
+        USLOSS_Console("Periodic(): ran 5 periods, once per period\n");
+    else
+        USLOSS_Console("ERROR: Periodic(): ran 5 periods in %d us\n", currentTime() - start);
+
+    quit(2);
+}
+
+int Overrun(void *arg)
+{
+    while (!stopOverrun)
+        ;
+
+    if (readtime() < 200000)
+        USLOSS_Console("Overrun(): was held to its budget\n");
+    else
+        USLOSS_Console("ERROR: Overrun(): got %d us of cpu\n", readtime());
+
+    quit(3);
+}
+
+int Spinner(void *arg)
+{
+    while (!stopSpinner)
+        ;
+
+    quit(1);
+}
@@ -0,0 +1,66 @@
+/*
+ * Checks priority inheritance through zap() and joinPid().
+ *
+ * testcase_main turns priority inheritance on and creates a priority 5
+ * child and a priority 4 child that spins for a while, and then zaps the
+ * priority 5 child.  The zapped child runs at testcase_main's priority
+ * until it quits, so it finishes before the spinner, which would otherwise
+ * keep it off the cpu.  Then the same
+ * is done with joinPid() instead of zap().
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Low(void *);
+int Mid(void *);
+
+int testcase_main()
+{
+    int status, low, mid, kidpid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Each time, Low finishes before Mid even though Mid has the higher priority.\n");
+
+    setPriorityInheritance(1);
+
+    low = spork("Low", Low, "zap", USLOSS_MIN_STACK, 5);
+    mid = spork("Mid", Mid, "zap", USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of children %d and %d, zapping %d\n", low, mid, low);
+    zap(low);
+    USLOSS_Console("testcase_main(): zap(%d) returned\n", low);
+
+    kidpid = joinPid(low, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    kidpid = joinPid(mid, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    low = spork("Low", Low, "joinPid", USLOSS_MIN_STACK, 5);
+    mid = spork("Mid", Mid, "joinPid", USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of children %d and %d, joining %d\n", low, mid, low);
+
+    kidpid = joinPid(low, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    kidpid = joinPid(mid, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    return 0;
+}
+
+int Low(void *arg)
+{
+    USLOSS_Console("Low(): %s test, running and quitting\n", (char *)arg);
+    quit(5);
+}
+
+int Mid(void *arg)
+{
+    int until = readtime() + 200000;
+
+    while (readtime() < until)
+        ;
+
+    USLOSS_Console("Mid(): %s test, done spinning\n", (char *)arg);
+    quit(4);
+}
@@ -0,0 +1,56 @@
+/*
+ * Checks aging.
+ *
+ * testcase_main turns aging on, creates a priority 5 child and a priority 4
+ * child that spins until the priority 5 child has run, and then joins.
+ * Without aging the priority 5 child would never run.  With aging it moves
+ * up while it waits, gets to run, and lets the spinner finish.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Low(void *);
+int Hog(void *);
+
+int lowRan = 0;
+
+int testcase_main()
+{
+    int status, low, hog, kidpid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Low runs while Hog is spinning, which ends Hog's spin.\n");
+
+    setAging(100000);
+
+    low = spork("Low", Low, NULL, USLOSS_MIN_STACK, 5);
+    hog = spork("Hog", Hog, NULL, USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of children %d and %d\n", low, hog);
+
+    kidpid = joinPid(low, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    kidpid = joinPid(hog, &status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    return 0;
+}
+
+int Low(void *arg)
+{
+    USLOSS_Console("Low(): running while Hog spins\n");
+    lowRan = 1;
+    quit(5);
+}
+
+int Hog(void *arg)
+{
+    USLOSS_Console("Hog(): spinning until Low has run\n");
+
+    while (!lowRan)
+        ;
+
+    USLOSS_Console("Hog(): Low has run\n");
+    quit(4);
+}
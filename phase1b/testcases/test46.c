@@ -0,0 +1,40 @@
+/*
+ * Checks the idle process and deadlock detection.
+ *
+ * testcase_main creates a child that blocks itself right away, and then
+ * blocks itself too.  init is waiting in join(), so no process is ready and
+ * no device request is out.  The idle process runs, finds that nothing can
+ * ever wake a process again, and halts.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(void *);
+
+int testcase_main()
+{
+    int pid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The idle process reports a deadlock once both processes are blocked.\n");
+
+    pid = spork("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of child %d, blocking\n", pid);
+
+    blockMe();
+
+    USLOSS_Console("ERROR: testcase_main(): blockMe() returned\n");
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    USLOSS_Console("XXp1(): blocking\n");
+
+    blockMe();
+
+    USLOSS_Console("ERROR: XXp1(): blockMe() returned\n");
+    quit(1);
+}
@@ -0,0 +1,66 @@
+/*
+ * Checks unblockAndSwitch().
+ *
+ * testcase_main creates a server at its own priority and spins until the
+ * server has had its turn and blocked, waiting for requests.  testcase_main
+ * sends it three requests with unblockAndSwitch().  Each time the server
+ * runs straight away, before testcase_main gets the cpu back, even though
+ * it does not have a higher priority.  unblockProc() would have left the
+ * server in the run queue until testcase_main's time slice was up.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Server(void *);
+
+int request = 0;
+int done = 0;
+int waiting = 0;
+
+int testcase_main()
+{
+    int status, pid, kidpid, i, rc;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The server answers each request before testcase_main goes on.\n");
+
+    pid = spork("Server", Server, NULL, USLOSS_MIN_STACK, 3);
+    USLOSS_Console("testcase_main(): after fork of child %d\n", pid);
+
+    while (!waiting)
+        ;
+
+    for (i = 1; i <= 3; i++)
+    {
+        request = i;
+        if (i == 3)
+            done = 1;
+        USLOSS_Console("testcase_main(): sending request %d\n", i);
+        rc = unblockAndSwitch(pid);
+        USLOSS_Console("testcase_main(): unblockAndSwitch() returned %d\n", rc);
+    }
+
+    rc = unblockAndSwitch(getpid());
+    USLOSS_Console("testcase_main(): unblockAndSwitch() of a process that is not blocked returned %d\n", rc);
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    return 0;
+}
+
+int Server(void *arg)
+{
+    USLOSS_Console("Server(): waiting for requests\n");
+
+    while (!done)
+    {
+        waiting = 1;
+        blockMe();
+        USLOSS_Console("Server(): served request %d\n", request);
+    }
+
+    quit(3);
+}
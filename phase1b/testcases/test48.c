@@ -0,0 +1,65 @@
+/*
+ * Checks unblockProcs().
+ *
+ * testcase_main creates three workers at a higher priority, each of which
+ * blocks straight away.  testcase_main then wakes all of them, plus a pid
+ * that is not blocked, with one unblockProcs() call.  The first worker to
+ * run dumps the process table: the other two workers must already be
+ * runnable, because the whole batch is woken before the scheduler picks
+ * anybody.  The workers run in the order they were listed.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Worker(void *);
+
+int first = 1;
+
+int testcase_main()
+{
+    int status, kidpid, i, rc;
+    int pids[4];
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: All three workers are runnable before the first one runs.\n");
+
+    for (i = 0; i < 3; i++)
+    {
+        char name[16];
+        sprintf(name, "Worker%d", i + 1);
+        pids[i] = spork(name, Worker, (void *)(long)(i + 1), USLOSS_MIN_STACK, 2);
+        USLOSS_Console("testcase_main(): after fork of child %d\n", pids[i]);
+    }
+    pids[3] = getpid();
+
+    USLOSS_Console("testcase_main(): waking the workers\n");
+    rc = unblockProcs(pids, 4);
+    USLOSS_Console("testcase_main(): unblockProcs() returned %d\n", rc);
+
+    for (i = 0; i < 3; i++)
+    {
+        kidpid = join(&status);
+        USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    }
+
+    return 0;
+}
+
+int Worker(void *arg)
+{
+    int id = (int)(long)arg;
+
+    USLOSS_Console("Worker%d(): blocking\n", id);
+    blockMe();
+    USLOSS_Console("Worker%d(): woken up\n", id);
+
+    if (first)
+    {
+        first = 0;
+        dumpProcesses();
+    }
+
+    return id;
+}
@@ -0,0 +1,65 @@
+/*
+ * Checks the wait queues.
+ *
+ * testcase_main creates three workers at a higher priority, each of which
+ * blocks on the same wait queue with reason 11.  dumpProcesses() shows the
+ * reason.  wakeOne() wakes the worker that has waited longest, and
+ * wakeAll() wakes the other two, oldest first.  After that the queue is
+ * empty, so wakeOne() returns -1 and wakeAll() returns 0.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Worker(void *);
+
+waitQueue queue;
+
+int testcase_main()
+{
+    int status, kidpid, i, rc;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The workers wake up in the order they blocked.\n");
+
+    for (i = 0; i < 3; i++)
+    {
+        char name[16];
+        sprintf(name, "Worker%d", i + 1);
+        kidpid = spork(name, Worker, (void *)(long)(i + 1), USLOSS_MIN_STACK, 2);
+        USLOSS_Console("testcase_main(): after fork of child %d\n", kidpid);
+    }
+
+    dumpProcesses();
+
+    rc = wakeOne(&queue);
+    USLOSS_Console("testcase_main(): wakeOne() returned %d\n", rc);
+
+    rc = wakeAll(&queue);
+    USLOSS_Console("testcase_main(): wakeAll() returned %d\n", rc);
+
+    rc = wakeOne(&queue);
+    USLOSS_Console("testcase_main(): wakeOne() of an empty queue returned %d\n", rc);
+    rc = wakeAll(&queue);
+    USLOSS_Console("testcase_main(): wakeAll() of an empty queue returned %d\n", rc);
+
+    for (i = 0; i < 3; i++)
+    {
+        kidpid = join(&status);
+        USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    }
+
+    return 0;
+}
+
+int Worker(void *arg)
+{
+    int id = (int)(long)arg;
+
+    USLOSS_Console("Worker%d(): waiting\n", id);
+    waitOn(&queue, 11);
+    USLOSS_Console("Worker%d(): woken up\n", id);
+
+    return id;
+}
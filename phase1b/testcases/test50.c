@@ -0,0 +1,91 @@
+/*
+ * Checks zapGroup() and zapTree().
+ *
+ * Family 1: Leader starts a new group and sporks Middle, which sporks
+ * Leaf and then starts a group of its own.  So Leader and Leaf are in
+ * Leader's group, Middle is not.  zapGroup() of Leader's group zaps two
+ * processes and returns once both have quit; Leaf dumps the process table
+ * while testcase_main waits.
+ *
+ * Family 2: the same tree, torn down with zapTree() of its root, which
+ * zaps all three processes.
+ *
+ * Every parent joins its children before it quits, so the processes quit
+ * from the bottom of the tree up.  Once Leader1 is joined its group has no
+ * processes left, so a second zapGroup() of it fails.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Leader(void *);
+int Middle(void *);
+int Leaf(void *);
+
+int dumped = 0;
+
+int testcase_main()
+{
+    int status, pid, rc;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Each call blocks once and returns after the last member has quit.\n");
+
+    pid = spork("Leader1", Leader, "1", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("testcase_main(): after fork of child %d\n", pid);
+    rc = zapGroup(pid);
+    USLOSS_Console("testcase_main(): zapGroup(%d) returned %d\n", pid, rc);
+    pid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", pid, status);
+    rc = zapGroup(pid);
+    USLOSS_Console("testcase_main(): zapGroup(%d) of the group that is gone returned %d\n", pid, rc);
+
+    pid = spork("Leader2", Leader, "2", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("testcase_main(): after fork of child %d\n", pid);
+    rc = zapTree(pid);
+    USLOSS_Console("testcase_main(): zapTree(%d) returned %d\n", pid, rc);
+    pid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", pid, status);
+
+    USLOSS_Console("testcase_main(): zapGroup(0) returned %d\n", zapGroup(0));
+    USLOSS_Console("testcase_main(): zapTree(99) returned %d\n", zapTree(99));
+
+    return 0;
+}
+
+int Leader(void *arg)
+{
+    int status, pid;
+
+    USLOSS_Console("Leader%s(): group %d\n", (char *)arg, newGroup());
+    pid = spork("Middle", Middle, arg, USLOSS_MIN_STACK, 2);
+    pid = join(&status);
+    USLOSS_Console("Leader%s(): joined %d, quitting\n", (char *)arg, pid);
+    return 1;
+}
+
+int Middle(void *arg)
+{
+    int status, pid;
+
+    pid = spork("Leaf", Leaf, arg, USLOSS_MIN_STACK, 4);
+    if (*(char *)arg == '1')
+        newGroup();
+    USLOSS_Console("Middle(): group %d\n", getGroup());
+    pid = join(&status);
+    USLOSS_Console("Middle(): joined %d, quitting\n", pid);
+    return 2;
+}
+
+int Leaf(void *arg)
+{
+    USLOSS_Console("Leaf(): group %d\n", getGroup());
+    if (!dumped)
+    {
+        dumped = 1;
+        dumpProcesses();
+    }
+    USLOSS_Console("Leaf(): quitting\n");
+    return 3;
+}
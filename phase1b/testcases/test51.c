@@ -0,0 +1,70 @@
+/*
+ * Checks sporkDetached().
+ *
+ * testcase_main creates 500 detached workers at a higher priority, one at
+ * a time.  Each one runs and quits straight away, and nobody joins it, so
+ * its pid and slot are free again before the next one is created.  Then
+ * testcase_main creates one more detached worker, at a lower priority, and
+ * one ordinary child.  dumpProcesses() shows the detached worker without a
+ * parent, and join() only ever returns the ordinary child.  testcase_main
+ * quits before the detached worker has run.  The stack pool shows that the
+ * workers kept reusing the same stack.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Worker(void *);
+int Child(void *);
+
+int ran = 0;
+
+int testcase_main()
+{
+    int status, pid, i;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Detached workers are never joined and leave nothing behind.\n");
+
+    for (i = 0; i < 500; i++)
+    {
+        pid = sporkDetached("Worker", Worker, NULL, USLOSS_MIN_STACK, 2);
+        if (pid < 0)
+        {
+            USLOSS_Console("testcase_main(): sporkDetached() failed with %d\n", pid);
+            USLOSS_Halt(1);
+        }
+    }
+    USLOSS_Console("testcase_main(): %d workers ran, the last pid was %d\n", ran, pid);
+
+    USLOSS_Console("testcase_main(): join() with only detached children returned %d\n", join(&status));
+
+    pid = sporkDetached("Late", Worker, NULL, USLOSS_MIN_STACK, 5);
+    USLOSS_Console("testcase_main(): after detached fork of %d\n", pid);
+    pid = spork("Child", Child, NULL, USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of child %d\n", pid);
+
+    setDumpStats(DUMP_STACK_POOL);
+    dumpProcesses();
+
+    pid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", pid, status);
+    USLOSS_Console("testcase_main(): join() again returned %d\n", join(&status));
+
+    return 0;
+}
+
+int Worker(void *arg)
+{
+    ran++;
+    if (ran > 500)
+        USLOSS_Console("Worker(): the late worker ran\n");
+    return 0;
+}
+
+int Child(void *arg)
+{
+    USLOSS_Console("Child(): running\n");
+    return 7;
+}
@@ -0,0 +1,67 @@
+/*
+ * Checks the worker pools.
+ *
+ * Pool 0 has two workers at a higher priority than testcase_main.  They
+ * run as soon as they are sporked and wait for jobs, which dumpProcesses()
+ * shows.  Each job testcase_main submits runs straight away.
+ *
+ * Pool 1 has two workers at a lower priority.  testcase_main submits four
+ * jobs, and the workers only get to them once testcase_main blocks in
+ * poolCollect().
+ *
+ * Once all results are collected, poolCollect() returns -2, and
+ * poolDestroy() joins the workers, so join() has no children left.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Square(void *);
+
+int testcase_main()
+{
+    int fast, slow, i, id, result, status;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Jobs run on the pool workers, no process is sporked for them.\n");
+
+    fast = poolCreate(2, 2, USLOSS_MIN_STACK);
+    USLOSS_Console("testcase_main(): poolCreate() returned %d\n", fast);
+    dumpProcesses();
+
+    for (i = 1; i <= 3; i++)
+    {
+        id = poolSubmit(fast, Square, (void *)(long)i);
+        USLOSS_Console("testcase_main(): submitted job %d\n", id);
+    }
+    while ((id = poolCollect(fast, &result)) > 0)
+        USLOSS_Console("testcase_main(): job %d returned %d\n", id, result);
+    USLOSS_Console("testcase_main(): poolCollect() of an empty pool returned %d\n", id);
+
+    slow = poolCreate(2, 4, USLOSS_MIN_STACK);
+    USLOSS_Console("testcase_main(): poolCreate() returned %d\n", slow);
+    for (i = 4; i <= 7; i++)
+    {
+        id = poolSubmit(slow, Square, (void *)(long)i);
+        USLOSS_Console("testcase_main(): submitted job %d\n", id);
+    }
+    while ((id = poolCollect(slow, &result)) > 0)
+        USLOSS_Console("testcase_main(): job %d returned %d\n", id, result);
+
+    USLOSS_Console("testcase_main(): poolDestroy() returned %d\n", poolDestroy(fast));
+    USLOSS_Console("testcase_main(): poolDestroy() returned %d\n", poolDestroy(slow));
+    USLOSS_Console("testcase_main(): poolSubmit() to a destroyed pool returned %d\n",
+                   poolSubmit(fast, Square, NULL));
+    USLOSS_Console("testcase_main(): join() returned %d\n", join(&status));
+
+    return 0;
+}
+
+int Square(void *arg)
+{
+    int n = (int)(long)arg;
+
+    USLOSS_Console("Square(): pid %d squares %d\n", getpid(), n);
+    return n * n;
+}
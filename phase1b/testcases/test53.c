@@ -0,0 +1,73 @@
+/*
+ * Checks setPriority().
+ *
+ * testcase_main (priority 3) creates A at priority 5 and B at priority 4,
+ * neither of which runs.  Raising A to priority 1 makes it run before
+ * setPriority() returns.
+ *
+ * C is created at priority 2 and blocks.  While it is blocked, it is
+ * lowered to priority 5, so unblockProc() no longer lets it run before
+ * testcase_main.
+ *
+ * testcase_main then lowers itself to priority 5: B, at priority 4, runs
+ * straight away.  testcase_main was preempted with time left, so it gets
+ * the cpu back before C, which is at the same priority.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Child(void *);
+
+int testcase_main()
+{
+    int a, b, c, rc, i, status, pid;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Each priority change takes effect at once.\n");
+
+    a = spork("A", Child, "A", USLOSS_MIN_STACK, 5);
+    b = spork("B", Child, "B", USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): after fork of children %d and %d\n", a, b);
+
+    rc = setPriority(a, 1);
+    USLOSS_Console("testcase_main(): setPriority(%d, 1) returned %d\n", a, rc);
+
+    c = spork("C", Child, "C", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("testcase_main(): after fork of child %d\n", c);
+    rc = setPriority(c, 5);
+    USLOSS_Console("testcase_main(): setPriority(%d, 5) returned %d\n", c, rc);
+    rc = unblockProc(c);
+    USLOSS_Console("testcase_main(): unblockProc(%d) returned %d\n", c, rc);
+
+    dumpProcesses();
+
+    rc = setPriority(getpid(), 5);
+    USLOSS_Console("testcase_main(): setPriority(%d, 5) returned %d\n", getpid(), rc);
+
+    USLOSS_Console("testcase_main(): setPriority(99, 1) returned %d\n", setPriority(99, 1));
+    USLOSS_Console("testcase_main(): setPriority(1, 1) returned %d\n", setPriority(1, 1));
+    USLOSS_Console("testcase_main(): setPriority(%d, 0) returned %d\n", getpid(), setPriority(getpid(), 0));
+
+    for (i = 0; i < 3; i++)
+    {
+        pid = join(&status);
+        USLOSS_Console("testcase_main(): exit status for child %d is %d\n", pid, status);
+    }
+
+    return 0;
+}
+
+int Child(void *arg)
+{
+    char *name = arg;
+
+    USLOSS_Console("%s(): running\n", name);
+    if (name[0] == 'C')
+    {
+        blockMe();
+        USLOSS_Console("%s(): after blockMe\n", name);
+    }
+    return name[0];
+}
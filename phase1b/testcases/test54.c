@@ -0,0 +1,52 @@
+/*
+ * Checks that detached processes that quit one after another are all freed.
+ *
+ * testcase_main creates ten detached workers at priority 4 and a child at
+ * priority 5, and joins the child.  The workers run and quit back to back
+ * before the child gets to run.  Every worker's stack must go back to the
+ * pool: the second round of ten workers takes all of its stacks from the
+ * pool, without a single miss.  Afterwards only init and testcase_main are
+ * left in the process table.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Worker(void *);
+int Child(void *);
+
+int ran = 0;
+
+int testcase_main()
+{
+    int round, i, pid, status;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The second round of workers reuses every stack of the first.\n");
+
+    setDumpStats(DUMP_STACK_POOL);
+
+    for (round = 1; round <= 2; round++)
+    {
+        for (i = 0; i < 10; i++)
+            sporkDetached("Worker", Worker, NULL, USLOSS_MIN_STACK, 4);
+        pid = spork("Child", Child, NULL, USLOSS_MIN_STACK, 5);
+        pid = join(&status);
+        USLOSS_Console("testcase_main(): round %d: %d workers ran, joined child %d\n", round, ran, pid);
+        dumpProcesses();
+    }
+
+    return 0;
+}
+
+int Worker(void *arg)
+{
+    ran++;
+    return 0;
+}
+
+int Child(void *arg)
+{
+    return 0;
+}
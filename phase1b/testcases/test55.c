@@ -0,0 +1,119 @@
+/*
+ * Checks the per-process statistics that DUMP_PROC_STATS prints.
+ *
+ * Deep fills a 40KB array on its stack and Shallow does not, so Deep's
+ * stack high-water mark must be at least 40KB above Shallow's.  Waiter has
+ * a lower priority than testcase_main, which spins for 200ms of cpu before
+ * it lets Waiter run, so Waiter's longest wait must be at least that long.
+ * Overrun is a real-time process that never calls waitPeriod(), so it
+ * misses every deadline, while Periodic, which does, misses none.
+ *
+ * The times depend on the clock, so only how they compare is printed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Deep(void *);
+int Shallow(void *);
+int Waiter(void *);
+int Periodic(void *);
+int Overrun(void *);
+
+int stopOverrun = 0;
+
+int testcase_main()
+{
+    int status, deep, shallow, waiter, periodic, overrun, until;
+    procStats stats, other;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Deep used 40KB more stack than Shallow, Waiter waited at least 200ms, Overrun missed its deadlines and Periodic did not.\n");
+
+    // stack high-water mark, both children are zombies so their stacks are still there
+    deep = spork("Deep", Deep, NULL, USLOSS_MIN_STACK, 2);
+    shallow = spork("Shallow", Shallow, NULL, USLOSS_MIN_STACK, 2);
+    getProcStats(deep, &stats);
+    getProcStats(shallow, &other);
+    USLOSS_Console("testcase_main(): Deep used 40KB more stack than Shallow: %s\n",
+                   (stats.stackUsed >= other.stackUsed + 40960) ? "yes" : "no");
+    USLOSS_Console("testcase_main(): Deep stayed inside its %d byte stack: %s\n",
+                   stats.stackSize, (stats.stackUsed <= stats.stackSize) ? "yes" : "no");
+    join(&status);
+    join(&status);
+
+    // longest wait, Waiter wakes testcase_main up as soon as it first runs
+    waiter = spork("Waiter", Waiter, (void *)(long)getpid(), USLOSS_MIN_STACK, 4);
+    until = readtime() + 200000;
+    while (readtime() < until)
+        ;
+    blockMe();
+    getProcStats(waiter, &stats);
+    USLOSS_Console("testcase_main(): Waiter waited at least 200ms: %s\n",
+                   (stats.maxWait >= 200000) ? "yes" : "no");
+    join(&status);
+
+    // deadline misses
+    periodic = sporkRealtime("Periodic", Periodic, NULL, USLOSS_MIN_STACK, 100000, 20000);
+    overrun = sporkRealtime("Overrun", Overrun, NULL, USLOSS_MIN_STACK, 100000, 20000);
+    until = readtime() + 300000;
+    while (readtime() < until)
+        ;
+    getProcStats(overrun, &stats);
+    USLOSS_Console("testcase_main(): Overrun missed at least 2 deadlines: %s\n",
+                   (stats.deadlineMisses >= 2) ? "yes" : "no");
+    USLOSS_Console("testcase_main(): Overrun was held to its budget: %s\n",
+                   (stats.cpuTime < 200000) ? "yes" : "no");
+    getProcStats(periodic, &stats);
+    USLOSS_Console("testcase_main(): Periodic missed %d deadlines\n", stats.deadlineMisses);
+
+    stopOverrun = 1;
+    joinPid(overrun, &status);
+    joinPid(periodic, &status);
+    USLOSS_Console("testcase_main(): getProcStats() of a process that was joined returned %d\n",
+                   getProcStats(periodic, &stats));
+
+    return 0;
+}
+
+int Deep(void *arg)
+{
+    volatile char buf[40960];
+
+    memset((char *)buf, 1, sizeof(buf));
+    quit(1);
+}
+
+int Shallow(void *arg)
+{
+    quit(2);
+}
+
+int Waiter(void *arg)
+{
+    unblockProc((int)(long)arg);
+    quit(3);
+}
+
+int Periodic(void *arg)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        int until = readtime() + 5000;
+        while (readtime() < until)
+            ;
+        waitPeriod();
+    }
+
+    quit(4);
+}
+
+int Overrun(void *arg)
+{
+    while (!stopOverrun)
+        ;
+
+    quit(5);
+}
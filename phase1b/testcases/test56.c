@@ -0,0 +1,70 @@
+/*
+ * Checks the dispatcher counts that DUMP_DISPATCH prints.
+ *
+ * testcase_main runs with interrupts off, so the clock cannot call the
+ * dispatcher behind its back.  It creates C, which blocks, and B, which
+ * has the same priority as testcase_main.  Turning DUMP_DISPATCH on starts
+ * the counts over, and the three dispatcher() calls that follow all take
+ * the fast path: B is left in its queue and testcase_main is never put
+ * back in one, so B does not run until testcase_main joins.
+ * unblockAndSwitch() then hands the cpu straight to C, which counts as a
+ * handoff and not as a dispatch, and C's quit() is one more dispatch that
+ * does not keep the running process.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXpB(void *);
+int XXpC(void *);
+
+int testcase_main()
+{
+    int i, status, pidB, pidC;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: 3 calls all on the fast path and B does not run, then 1 handoff to C, then C's quit adds a call that is not on the fast path.\n");
+
+    USLOSS_PsrSet(USLOSS_PsrGet() & ~USLOSS_PSR_CURRENT_INT);
+
+    pidC = spork("XXpC", XXpC, NULL, USLOSS_MIN_STACK, 2);
+    pidB = spork("XXpB", XXpB, NULL, USLOSS_MIN_STACK, 3);
+    USLOSS_Console("testcase_main(): after fork of children %d and %d\n", pidC, pidB);
+
+    setDumpStats(DUMP_DISPATCH);
+    for (i = 0; i < 3; i++)
+        dispatcher();
+    USLOSS_Console("testcase_main(): after 3 calls to dispatcher()\n");
+    dumpProcesses();
+
+    unblockAndSwitch(pidC);
+    USLOSS_Console("testcase_main(): after unblockAndSwitch(%d)\n", pidC);
+    dumpProcesses();
+
+    for (i = 0; i < 2; i++)
+    {
+        join(&status);
+        USLOSS_Console("testcase_main(): joined a child, status %d\n", status);
+    }
+
+    return 0;
+}
+
+int XXpB(void *arg)
+{
+    USLOSS_Console("XXpB(): running\n");
+    quit(2);
+}
+
+int XXpC(void *arg)
+{
+    // with interrupts off when it blocks, it also has them off when it wakes up
+    USLOSS_PsrSet(USLOSS_PsrGet() & ~USLOSS_PSR_CURRENT_INT);
+
+    USLOSS_Console("XXpC(): blocking\n");
+    blockMe();
+    USLOSS_Console("XXpC(): running after the handoff\n");
+    dumpProcesses();
+    quit(1);
+}
@@ -0,0 +1,64 @@
+/*
+ * Checks that setPriority() takes back a level a blocked process lent.
+ *
+ * With priority inheritance on, Holder blocks at priority 2 and is then
+ * lowered to priority 5.  Zapper, at priority 1, zaps Holder, so Holder
+ * inherits priority 1.  testcase_main (priority 3) then lowers Zapper to
+ * priority 4, which must take the lent level back: when testcase_main
+ * unblocks Holder, Holder runs at priority 4 and does not get the cpu until
+ * testcase_main joins.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Holder(void *);
+int Zapper(void *);
+
+int holder;
+
+int testcase_main()
+{
+    int rc, i, status, pid, zapper;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Holder runs only after testcase_main joins, since Zapper no longer lends it priority 1.\n");
+
+    setPriorityInheritance(1);
+
+    holder = spork("Holder", Holder, NULL, USLOSS_MIN_STACK, 2);
+    rc = setPriority(holder, 5);
+    USLOSS_Console("testcase_main(): setPriority(%d, 5) returned %d\n", holder, rc);
+
+    zapper = spork("Zapper", Zapper, NULL, USLOSS_MIN_STACK, 1);
+    rc = setPriority(zapper, 4);
+    USLOSS_Console("testcase_main(): setPriority(%d, 4) returned %d\n", zapper, rc);
+
+    rc = unblockProc(holder);
+    USLOSS_Console("testcase_main(): unblockProc(%d) returned %d\n", holder, rc);
+
+    for (i = 0; i < 2; i++)
+    {
+        pid = join(&status);
+        USLOSS_Console("testcase_main(): exit status for child %d is %d\n", pid, status);
+    }
+
+    return 0;
+}
+
+int Holder(void *arg)
+{
+    USLOSS_Console("Holder(): blocking\n");
+    blockMe();
+    USLOSS_Console("Holder(): running\n");
+    return 1;
+}
+
+int Zapper(void *arg)
+{
+    USLOSS_Console("Zapper(): zapping %d\n", holder);
+    zap(holder);
+    USLOSS_Console("Zapper(): zap returned\n");
+    return 2;
+}
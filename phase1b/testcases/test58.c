@@ -0,0 +1,47 @@
+/*
+ * Checks the order join() reaps children in when they terminate out of
+ * order.
+ *
+ * testcase_main creates five children at priority 2, each of which blocks.
+ * It then unblocks them fourth, first, fifth, second and third, and each
+ * one runs and quits straight away.  So the zombie list is built from an
+ * empty list, at its tail, at its head and twice in its middle.  join()
+ * must still return the children newest first, from the highest pid down.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(void *);
+
+int testcase_main()
+{
+    int pid[5], order[5] = {3, 0, 4, 1, 2};
+    int i, kidpid, status;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The children quit in the order 4th, 1st, 5th, 2nd, 3rd, and join() returns them from the highest pid down.\n");
+
+    for (i = 0; i < 5; i++)
+        pid[i] = spork("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 2);
+
+    for (i = 0; i < 5; i++)
+        unblockProc(pid[order[i]]);
+
+    for (i = 0; i < 5; i++)
+    {
+        kidpid = join(&status);
+        USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    }
+
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    USLOSS_Console("XXp1(): %d blocking\n", getpid());
+    blockMe();
+    USLOSS_Console("XXp1(): %d quitting\n", getpid());
+    quit(getpid() * 10);
+}
@@ -0,0 +1,60 @@
+/*
+ * Checks that SCHED_FAIR does not let a new process catch up on the time
+ * another one ran alone.
+ *
+ * testcase_main switches to SCHED_FAIR and spins alone for 1 second of cpu.
+ * It then creates a spinner at its own priority and spins for another
+ * 200ms of cpu.  The two share the cpu evenly, so the spinner gets about
+ * 200ms too.  If the spinner started with the virtual runtime of an idle
+ * system it would get the whole second testcase_main ran alone first.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(void *);
+
+int stop = 0;
+
+int testcase_main()
+{
+    int status, pid, kidpid, until;
+    procStats stats;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The child gets about as much cpu as testcase_main once it is created, not the second testcase_main ran alone.\n");
+
+    setSchedPolicy(SCHED_FAIR);
+
+    until = readtime() + 1000000;
+    while (readtime() < until)
+        ;
+
+    pid = spork("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 3);
+    USLOSS_Console("testcase_main(): after fork of child %d\n", pid);
+
+    until = readtime() + 200000;
+    while (readtime() < until)
+        ;
+
+    getProcStats(pid, &stats);
+    if (stats.cpuTime < 400000)
+        USLOSS_Console("testcase_main(): the cpu was shared evenly\n");
+    else
+        USLOSS_Console("ERROR: testcase_main(): the child got %d us of cpu to testcase_main's 200000\n", stats.cpuTime);
+
+    stop = 1;
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    while (!stop)
+        ;
+
+    quit(1);
+}
@@ -0,0 +1,52 @@
+/*
+ * Checks that aging does not miss a process queued behind a newer one.
+ *
+ * With an aging period of 200ms, testcase_main creates Old at priority 5
+ * and spins for 150ms.  It then creates New at priority 4 and moves Old to
+ * priority 4 too.  Old goes behind New in the queue but has been waiting
+ * since the start, so it moves up a priority when it has waited 200ms,
+ * while New still has 150ms to go.  When testcase_main blocks at 250ms Old
+ * is at priority 3 and New at 4, so Old runs first.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(void *);
+
+int testcase_main()
+{
+    int i, status, kidpid, oldPid, newPid, until;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Old moves up when it has waited 200ms even though it is behind New, so it runs first.\n");
+
+    setAging(200000);
+
+    until = readtime() + 150000;
+    oldPid = spork("Old", XXp1, "Old", USLOSS_MIN_STACK, 5);
+    while (readtime() < until)
+        ;
+
+    until = readtime() + 100000;
+    newPid = spork("New", XXp1, "New", USLOSS_MIN_STACK, 4);
+    USLOSS_Console("testcase_main(): setPriority(%d, 4) returned %d\n", oldPid, setPriority(oldPid, 4));
+    while (readtime() < until)
+        ;
+
+    for (i = 0; i < 2; i++)
+    {
+        kidpid = join(&status);
+        USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    }
+    USLOSS_Console("testcase_main(): New was child %d\n", newPid);
+
+    return 0;
+}
+
+int XXp1(void *arg)
+{
+    USLOSS_Console("%s(): running\n", (char *)arg);
+    return ((char *)arg)[0];
+}
@@ -0,0 +1,72 @@
+/*
+ * Checks poolDestroy() with processes still waiting in poolCollect().
+ *
+ * testcase_main submits one job to a pool and creates two collectors at
+ * priority 2, which both block in poolCollect().  The second one is then
+ * lowered to priority 5.  poolDestroy() runs the job, which the first
+ * collector gets, and wakes the second one, which does not run yet.
+ * testcase_main creates a new pool in the same slot and collects a job
+ * from it.  When the second collector finally runs it gets -1, since its
+ * pool is gone, and not the new pool's results.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Square(void *);
+int Collector(void *);
+
+int pool;
+
+int testcase_main()
+{
+    int i, id, result, status, pid1, pid2;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: The first collector gets the job, the second one gets -1 after the slot is reused.\n");
+
+    pool = poolCreate(1, 4, USLOSS_MIN_STACK);
+    id = poolSubmit(pool, Square, (void *)3L);
+    USLOSS_Console("testcase_main(): submitted job %d to pool %d\n", id, pool);
+
+    pid1 = spork("Collector1", Collector, "1", USLOSS_MIN_STACK, 2);
+    pid2 = spork("Collector2", Collector, "2", USLOSS_MIN_STACK, 2);
+    setPriority(pid2, 5);
+
+    USLOSS_Console("testcase_main(): poolDestroy() returned %d\n", poolDestroy(pool));
+
+    pool = poolCreate(1, 4, USLOSS_MIN_STACK);
+    id = poolSubmit(pool, Square, (void *)5L);
+    USLOSS_Console("testcase_main(): submitted job %d to pool %d\n", id, pool);
+    id = poolCollect(pool, &result);
+    USLOSS_Console("testcase_main(): job %d returned %d\n", id, result);
+    USLOSS_Console("testcase_main(): poolDestroy() returned %d\n", poolDestroy(pool));
+
+    for (i = 0; i < 2; i++)
+    {
+        id = join(&status);
+        USLOSS_Console("testcase_main(): exit status for child %d is %d\n", id, status);
+    }
+    USLOSS_Console("testcase_main(): the collectors were %d and %d\n", pid1, pid2);
+
+    return 0;
+}
+
+int Square(void *arg)
+{
+    int n = (int)(long)arg;
+
+    USLOSS_Console("Square(): pid %d squares %d\n", getpid(), n);
+    return n * n;
+}
+
+int Collector(void *arg)
+{
+    int id, result = 0;
+
+    USLOSS_Console("Collector%s(): collecting from pool %d\n", (char *)arg, pool);
+    id = poolCollect(pool, &result);
+    USLOSS_Console("Collector%s(): poolCollect() returned %d, result %d\n", (char *)arg, id, result);
+    return id;
+}